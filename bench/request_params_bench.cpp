@@ -0,0 +1,113 @@
+// Compares Poco::Net::HTMLForm with RequestParams on typical /author query strings:
+// heap allocations and time per parsed request.
+
+#include "../web_server/handlers/request_params.h"
+
+#include "Poco/Net/HTMLForm.h"
+#include "Poco/Timestamp.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+static std::atomic<size_t> allocations{0};
+
+void *operator new(size_t size)
+{
+    ++allocations;
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+struct Result
+{
+    double allocations_per_request;
+    double ns_per_request;
+};
+
+template <typename Parse>
+static Result measure(const std::vector<std::string> &queries, size_t rounds, Parse parse)
+{
+    size_t sink = 0;
+    size_t before = allocations;
+    Poco::Timestamp started;
+    for (size_t r = 0; r < rounds; ++r)
+        for (const auto &q : queries)
+            sink += parse(q);
+    double elapsed_ns = static_cast<double>(started.elapsed()) * 1000.0;
+    double requests = static_cast<double>(rounds * queries.size());
+    static volatile size_t keep;
+    keep = sink;
+    return {static_cast<double>(allocations - before) / requests, elapsed_ns / requests};
+}
+
+int main(int argc, char *argv[])
+{
+    size_t rounds = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    std::vector<std::string> queries = {
+        "id=12345",
+        "search&first_name=Elle&last_name=A",
+        "add&first_name=%D0%98%D0%B2%D0%B0%D0%BD&last_name=Ivanov&email=ivanov%40yandex.ru&title=Mr",
+        "email=Chad_Cavanagh1998%40nickia.com",
+        ""};
+
+    Result form = measure(queries, rounds, [](const std::string &q) {
+        Poco::Net::HTMLForm f;
+        f.read(q);
+        size_t n = 0;
+        if (f.has("id"))
+            n += atol(f.get("id").c_str());
+        else if (f.has("search"))
+            n += f.get("first_name").size() + f.get("last_name").size();
+        else if (f.has("add"))
+            n += f.get("first_name").size() + f.get("email").size();
+        else if (f.has("email"))
+            n += f.get("email").size();
+        return n;
+    });
+
+    Result params = measure(queries, rounds, [](const std::string &q) {
+        RequestParams p;
+        p.parse(q, std::string_view());
+        size_t n = 0;
+        long id = 0;
+        switch (p.operation())
+        {
+        case RequestParams::Operation::ById:
+            n += p.get_long("id", id) ? id : 0;
+            break;
+        case RequestParams::Operation::Search:
+            n += p.get("first_name").size() + p.get("last_name").size();
+            break;
+        case RequestParams::Operation::Add:
+            n += p.get("first_name").size() + p.get("email").size();
+            break;
+        case RequestParams::Operation::Email:
+            n += p.get("email").size();
+            break;
+        case RequestParams::Operation::List:
+            break;
+        }
+        return n;
+    });
+
+    std::cout << "HTMLForm:      " << form.allocations_per_request << " allocations/request, "
+              << form.ns_per_request << " ns/request" << std::endl;
+    std::cout << "RequestParams: " << params.allocations_per_request << " allocations/request, "
+              << params.ns_per_request << " ns/request" << std::endl;
+    return 0;
+}
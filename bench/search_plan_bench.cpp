@@ -0,0 +1,161 @@
+// Compares the planned Author searches with the old unbounded
+// "first_name LIKE ? and last_name LIKE ?" query. Fills Author up to the
+// requested row count (default one million) with synthetic names, prints
+// EXPLAIN for every plan and the mean latency of both query forms.
+//
+// usage: search_plan_bench host login password database [rows] [repeats]
+// the Author table must exist; the composite indexes are added if it lacks them
+
+#include "../config/config.h"
+#include "../database/database.h"
+#include "../database/author.h"
+#include "../database/mysql_author_storage.h"
+
+#include <Poco/Data/RecordSet.h>
+#include <Poco/Timestamp.h>
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace Poco::Data::Keywords;
+using Poco::Data::Statement;
+
+namespace
+{
+    const std::vector<std::string> first_names = {"Anna", "Boris", "Chad", "Daria", "Elle", "Fedor", "Gleb", "Hanna",
+                                                  "Ivan", "Julia", "Kirill", "Lena", "Maria", "Nikita", "Olga", "Pavel"};
+    const std::vector<std::string> last_names = {"Abramov", "Belova", "Cavanagh", "Dmitriev", "Egorova", "Frolov",
+                                                 "Gromova", "Hall", "Ivanov", "Jones", "Kuznetsova", "Lebedev"};
+
+    std::string suffix(long n)
+    {
+        std::string s;
+        s += static_cast<char>('a' + n % 26);
+        s += static_cast<char>('a' + n / 26 % 26);
+        return s;
+    }
+
+    void populate(long wanted)
+    {
+        long existing = database::Author::count();
+        if (existing >= wanted)
+            return;
+        std::cout << "populating " << (wanted - existing) << " rows" << std::endl;
+        Poco::Data::Session session = database::Database::get().create_session();
+        std::vector<database::Author> batch;
+        for (long i = existing; i < wanted; ++i)
+        {
+            database::Author a;
+            a.first_name() = first_names[i % first_names.size()] + suffix(i / 16);
+            a.last_name() = last_names[i / 7 % last_names.size()] + suffix(i / 97);
+            a.email() = "user" + std::to_string(i) + "@example.com";
+            a.title() = "Mr";
+            batch.push_back(std::move(a));
+            if (batch.size() == 1000 || i + 1 == wanted)
+            {
+                session.begin();
+                database::MySQLAuthorStorage::save_batch(session, batch);
+                session.commit();
+                batch.clear();
+            }
+        }
+    }
+
+    void explain(const database::MySQLAuthorStorage::SearchPlan &plan)
+    {
+        Poco::Data::Session session = database::Database::get().create_session();
+        std::vector<std::string> params = plan.params;
+        long limit = Config::get().get_search_limit();
+        Statement select(session);
+        select << "EXPLAIN " + plan.sql;
+        for (auto &p : params)
+            select.addBind(use(p));
+        select.addBind(use(limit));
+        select.execute();
+        Poco::Data::RecordSet rs(select);
+        for (bool more = rs.moveFirst(); more; more = rs.moveNext())
+            std::cout << "    table=" << rs["table"].convert<std::string>()
+                      << " key=" << (rs["key"].isEmpty() ? "NULL" : rs["key"].convert<std::string>())
+                      << " rows=" << (rs["rows"].isEmpty() ? "NULL" : rs["rows"].convert<std::string>())
+                      << " extra=" << (rs["Extra"].isEmpty() ? "" : rs["Extra"].convert<std::string>()) << std::endl;
+    }
+
+    double legacy_search_ms(std::string first_name, std::string last_name, int repeats, size_t &rows)
+    {
+        Poco::Data::Session session = database::Database::get().create_session();
+        first_name += "%";
+        last_name += "%";
+        Poco::Timestamp started;
+        for (int r = 0; r < repeats; ++r)
+        {
+            std::vector<long> ids;
+            std::vector<std::string> fns, lns, ems, tts;
+            session << "SELECT id, first_name, last_name, email, title FROM Author where first_name LIKE ? and last_name LIKE ?",
+                into(ids), into(fns), into(lns), into(ems), into(tts), use(first_name), use(last_name), now;
+            rows = ids.size();
+        }
+        return static_cast<double>(started.elapsed()) / 1000.0 / repeats;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 5)
+    {
+        std::cout << "usage: " << argv[0] << " host login password database [rows] [repeats]" << std::endl;
+        return 1;
+    }
+    Config::get().host() = argv[1];
+    Config::get().login() = argv[2];
+    Config::get().password() = argv[3];
+    Config::get().database() = argv[4];
+    long rows = argc > 5 ? std::atol(argv[5]) : 1000000;
+    int repeats = argc > 6 ? std::atoi(argv[6]) : 20;
+
+    populate(rows);
+    // missing keys are built once after the fill instead of being maintained per insert
+    database::Author::create_indexes();
+
+    struct Case
+    {
+        std::string first_name;
+        std::string last_name;
+        bool exact;
+    };
+    std::vector<Case> cases = {
+        {"", "", false},
+        {"Elle", "", false},
+        {"", "Cav", false},
+        {"Ell", "C", false},
+        {"Ivanaa", "", true},
+        {"Ivanaa", "Ivanovaa", true},
+        {"E", "", false},
+    };
+
+    database::MySQLAuthorStorage storage;
+    std::cout << std::fixed << std::setprecision(2);
+    for (auto &c : cases)
+    {
+        auto plan = database::MySQLAuthorStorage::plan_search(c.first_name, c.last_name, c.exact);
+        std::cout << plan.name << " first_name='" << c.first_name << "' last_name='" << c.last_name << "'" << std::endl;
+        explain(plan);
+
+        size_t planned_rows = 0;
+        Poco::Timestamp started;
+        for (int r = 0; r < repeats; ++r)
+            planned_rows = storage.search(c.first_name, c.last_name, c.exact).size();
+        double planned_ms = static_cast<double>(started.elapsed()) / 1000.0 / repeats;
+        std::cout << "    planned: " << planned_ms << " ms, " << planned_rows << " rows" << std::endl;
+
+        if (!c.exact)
+        {
+            size_t legacy_rows = 0;
+            double legacy_ms = legacy_search_ms(c.first_name, c.last_name, repeats, legacy_rows);
+            std::cout << "    legacy:  " << legacy_ms << " ms, " << legacy_rows << " rows" << std::endl;
+        }
+    }
+    return 0;
+}
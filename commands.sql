@@ -1,6 +1,6 @@
 use sql_test; 
 show tables;
-CREATE TABLE IF NOT EXISTS `Author` (`id` INT NOT NULL AUTO_INCREMENT,`first_name` VARCHAR(256) CHARACTER SET utf8 COLLATE utf8_unicode_ci NOT NULL,`last_name` VARCHAR(256) CHARACTER SET utf8 COLLATE utf8_unicode_ci NOT NULL,`email` VARCHAR(256) CHARACTER SET utf8 COLLATE utf8_unicode_ci NULL,`title` VARCHAR(1024) CHARACTER SET utf8 COLLATE utf8_unicode_ci NULL,PRIMARY KEY (`id`),KEY `fn` (`first_name`),KEY `ln` (`last_name`));
+CREATE TABLE IF NOT EXISTS `Author` (`id` INT NOT NULL AUTO_INCREMENT,`first_name` VARCHAR(256) CHARACTER SET utf8 COLLATE utf8_unicode_ci NOT NULL,`last_name` VARCHAR(256) CHARACTER SET utf8 COLLATE utf8_unicode_ci NOT NULL,`email` VARCHAR(256) CHARACTER SET utf8 COLLATE utf8_unicode_ci NULL,`title` VARCHAR(1024) CHARACTER SET utf8 COLLATE utf8_unicode_ci NULL,PRIMARY KEY (`id`),KEY `fn_ln` (`first_name`,`last_name`),KEY `ln_fn` (`last_name`,`first_name`),KEY `em` (`email`));
 describe Author;
 select * from Author where id<10;
 select id,first_name,last_name from Author where id>=10 and id<20;
@@ -21,4 +21,11 @@ drop index fn_ln on Author;
 create index fn_ln using btree on Author(first_name,last_name);
 drop index ln_fn on Author;
 create index ln_fn using btree on Author(last_name,first_name);
-explain format=json select * from Author where first_name='Elle%' and last_name='A%';
\ No newline at end of file
+explain format=json select * from Author where first_name='Elle%' and last_name='A%';
+-- search planner: composite keys replace fn/ln, ids come from the index, rows are joined back
+show index from Author;
+explain select a.id, a.first_name, a.last_name, a.email, a.title from Author a join (select id from Author force index (`fn_ln`) where first_name like 'Elle%' order by id limit 1000) k on a.id = k.id order by a.id;
+explain select a.id, a.first_name, a.last_name, a.email, a.title from Author a join (select id from Author force index (`ln_fn`) where last_name like 'Cav%' order by id limit 1000) k on a.id = k.id order by a.id;
+explain select a.id, a.first_name, a.last_name, a.email, a.title from Author a join (select id from Author force index (`fn_ln`) where first_name like 'Ell%' and last_name like 'C%' order by id limit 1000) k on a.id = k.id order by a.id;
+explain select a.id, a.first_name, a.last_name, a.email, a.title from Author a join (select id from Author force index (`fn_ln`) where first_name = 'Elle' and last_name = 'Abramov' order by id limit 1000) k on a.id = k.id order by a.id;
+explain select a.id, a.first_name, a.last_name, a.email, a.title from Author a order by a.id limit 1000;
@@ -1,6 +1,6 @@
 #include "config.h"
 
-Config::Config()
+Config::Config() : _storage("mysql"), _request_timeout(5000), _max_request_timeout(30000), _search_limit(1000)
 {
 }
 
@@ -34,6 +34,26 @@ const std::string &Config::get_database() const
     return _database;
 }
 
+const std::string &Config::get_storage() const
+{
+    return _storage;
+}
+
+long Config::get_request_timeout() const
+{
+    return _request_timeout;
+}
+
+long Config::get_max_request_timeout() const
+{
+    return _max_request_timeout;
+}
+
+long Config::get_search_limit() const
+{
+    return _search_limit;
+}
+
 std::string &Config::port()
 {
     return _port;
@@ -57,4 +77,24 @@ std::string &Config::password()
 std::string &Config::database()
 {
     return _database;
+}
+
+std::string &Config::storage()
+{
+    return _storage;
+}
+
+long &Config::request_timeout()
+{
+    return _request_timeout;
+}
+
+long &Config::max_request_timeout()
+{
+    return _max_request_timeout;
+}
+
+long &Config::search_limit()
+{
+    return _search_limit;
 }
\ No newline at end of file
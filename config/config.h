@@ -11,6 +11,10 @@ class  Config{
         std::string _login;
         std::string _password;
         std::string _database;
+        std::string _storage;
+        long _request_timeout;
+        long _max_request_timeout;
+        long _search_limit;
 
     public:
         static Config& get();
@@ -20,12 +24,20 @@ class  Config{
         std::string& login();
         std::string& password();
         std::string& database();
+        std::string& storage();
+        long& request_timeout();
+        long& max_request_timeout();
+        long& search_limit();
 
         const std::string& get_port() const ;
         const std::string& get_host() const ;
         const std::string& get_login() const ;
         const std::string& get_password() const ;
         const std::string& get_database() const ;
+        const std::string& get_storage() const ;
+        long get_request_timeout() const ;
+        long get_max_request_timeout() const ;
+        long get_search_limit() const ;
 };
 
 #endif
\ No newline at end of file
@@ -1,59 +1,19 @@
 #include "author.h"
-#include "database.h"
-#include "../config/config.h"
+#include "author_storage.h"
+#include "mysql_author_storage.h"
+#include "email_filter.h"
+#include "author_stats.h"
+#include "change_log.h"
 
-#include <Poco/Data/MySQL/Connector.h>
-#include <Poco/Data/MySQL/MySQLException.h>
-#include <Poco/Data/SessionFactory.h>
-#include <Poco/Data/RecordSet.h>
 #include <Poco/JSON/Parser.h>
 #include <Poco/Dynamic/Var.h>
 
 #include <sstream>
 #include <exception>
 
-using namespace Poco::Data::Keywords;
-using Poco::Data::Session;
-using Poco::Data::Statement;
-
 namespace database
 {
 
-    void Author::init()
-    {
-        try
-        {
-
-            Poco::Data::Session session = database::Database::get().create_session();
-            //*
-            Statement drop_stmt(session);
-            drop_stmt << "DROP TABLE IF EXISTS Author", now;
-            //*/
-
-            // (re)create table
-            Statement create_stmt(session);
-            create_stmt << "CREATE TABLE IF NOT EXISTS `Author` (`id` INT NOT NULL AUTO_INCREMENT,"
-                        << "`first_name` VARCHAR(256) CHARACTER SET utf8 COLLATE utf8_unicode_ci NOT NULL,"
-                        << "`last_name` VARCHAR(256) CHARACTER SET utf8 COLLATE utf8_unicode_ci NOT NULL,"
-                        << "`email` VARCHAR(256) CHARACTER SET utf8 COLLATE utf8_unicode_ci NULL,"
-                        << "`title` VARCHAR(1024) CHARACTER SET utf8 COLLATE utf8_unicode_ci NULL,"
-                        << "PRIMARY KEY (`id`),KEY `fn` (`first_name`),KEY `ln` (`last_name`));",
-                now;
-        }
-
-        catch (Poco::Data::MySQL::ConnectionException &e)
-        {
-            std::cout << "connection:" << e.what() << std::endl;
-            throw;
-        }
-        catch (Poco::Data::MySQL::StatementException &e)
-        {
-
-            std::cout << "statement:" << e.what() << std::endl;
-            throw;
-        }
-    }
-
     Poco::JSON::Object::Ptr Author::toJSON() const
     {
         Poco::JSON::Object::Ptr root = new Poco::JSON::Object();
@@ -83,158 +43,112 @@ namespace database
         return author;
     }
 
-    Author Author::read_by_id(long id)
+    bool Author::check_name(const std::string &name, std::string &reason)
     {
-        try
+        if (name.length() < 3)
         {
-            Poco::Data::Session session = database::Database::get().create_session();
-            Poco::Data::Statement select(session);
-            Author a;
-            select << "SELECT id, first_name, last_name, email, title FROM Author where id=?",
-                into(a._id),
-                into(a._first_name),
-                into(a._last_name),
-                into(a._email),
-                into(a._title),
-                use(id),
-                range(0, 1); //  iterate over result set one row at a time
-            select.execute();
-            Poco::Data::RecordSet rs(select);
-            if (!rs.moveFirst()) throw std::logic_error("not found");
-
-            return a;
+            reason = "Name must be at leas 3 signs";
+            return false;
         }
 
-        catch (Poco::Data::MySQL::ConnectionException &e)
+        if (name.find(' ') != std::string::npos)
         {
-            std::cout << "connection:" << e.what() << std::endl;
-            throw;
+            reason = "Name can't contain spaces";
+            return false;
         }
-        catch (Poco::Data::MySQL::StatementException &e)
-        {
 
-            std::cout << "statement:" << e.what() << std::endl;
-            throw;
+        if (name.find('\t') != std::string::npos)
+        {
+            reason = "Name can't contain spaces";
+            return false;
         }
+
+        return true;
     }
 
-    std::vector<Author> Author::read_all()
+    bool Author::check_email(const std::string &email, std::string &reason)
     {
-        try
+        if (email.find('@') == std::string::npos)
         {
-            Poco::Data::Session session = database::Database::get().create_session();
-            Statement select(session);
-            std::vector<Author> result;
-            Author a;
-            select << "SELECT id, first_name, last_name, email, title FROM Author",
-                into(a._id),
-                into(a._first_name),
-                into(a._last_name),
-                into(a._email),
-                into(a._title),
-                range(0, 1); //  iterate over result set one row at a time
-
-            while (!select.done())
-            {
-                select.execute();
-                result.push_back(a);
-            }
-            return result;
+            reason = "Email must contain @";
+            return false;
         }
 
-        catch (Poco::Data::MySQL::ConnectionException &e)
+        if (email.find(' ') != std::string::npos)
         {
-            std::cout << "connection:" << e.what() << std::endl;
-            throw;
+            reason = "EMail can't contain spaces";
+            return false;
         }
-        catch (Poco::Data::MySQL::StatementException &e)
-        {
 
-            std::cout << "statement:" << e.what() << std::endl;
-            throw;
+        if (email.find('\t') != std::string::npos)
+        {
+            reason = "EMail can't contain spaces";
+            return false;
         }
+
+        return true;
     }
 
-    std::vector<Author> Author::search(std::string first_name, std::string last_name)
+    void Author::init()
     {
-        try
-        {
-            Poco::Data::Session session = database::Database::get().create_session();
-            Statement select(session);
-            std::vector<Author> result;
-            Author a;
-            first_name+="%";
-            last_name+="%";
-            select << "SELECT id, first_name, last_name, email, title FROM Author where first_name LIKE ? and last_name LIKE ?",
-                into(a._id),
-                into(a._first_name),
-                into(a._last_name),
-                into(a._email),
-                into(a._title),
-                use(first_name),
-                use(last_name),
-                range(0, 1); //  iterate over result set one row at a time
-
-            while (!select.done())
-            {
-                select.execute();
-                result.push_back(a);
-            }
-            return result;
-        }
+        AuthorStorage::get().init();
+    }
 
-        catch (Poco::Data::MySQL::ConnectionException &e)
-        {
-            std::cout << "connection:" << e.what() << std::endl;
-            throw;
-        }
-        catch (Poco::Data::MySQL::StatementException &e)
-        {
+    void Author::create_indexes()
+    {
+        MySQLAuthorStorage::create_indexes();
+    }
 
-            std::cout << "statement:" << e.what() << std::endl;
-            throw;
-        }
+    void Author::drop_indexes()
+    {
+        MySQLAuthorStorage::drop_indexes();
     }
 
-   
-    void Author::save_to_mysql()
+    Author Author::read_by_id(long id)
     {
+        return AuthorStorage::get().read_by_id(id);
+    }
 
-        try
-        {
-            Poco::Data::Session session = database::Database::get().create_session();
-            Poco::Data::Statement insert(session);
-
-            insert << "INSERT INTO Author (first_name,last_name,email,title) VALUES(?, ?, ?, ?)",
-                use(_first_name),
-                use(_last_name),
-                use(_email),
-                use(_title);
-
-            insert.execute();
-
-            Poco::Data::Statement select(session);
-            select << "SELECT LAST_INSERT_ID()",
-                into(_id),
-                range(0, 1); //  iterate over result set one row at a time
-
-            if (!select.done())
-            {
-                select.execute();
-            }
-            std::cout << "inserted:" << _id << std::endl;
-        }
-        catch (Poco::Data::MySQL::ConnectionException &e)
-        {
-            std::cout << "connection:" << e.what() << std::endl;
-            throw;
-        }
-        catch (Poco::Data::MySQL::StatementException &e)
-        {
+    Author Author::read_by_email(std::string email)
+    {
+        return AuthorStorage::get().read_by_email(email);
+    }
 
-            std::cout << "statement:" << e.what() << std::endl;
-            throw;
-        }
+    long Author::count()
+    {
+        return AuthorStorage::get().count();
+    }
+
+    std::vector<Author> Author::read_all()
+    {
+        return AuthorStorage::get().read_all();
+    }
+
+    std::vector<Author> Author::search(std::string first_name, std::string last_name, bool exact)
+    {
+        return AuthorStorage::get().search(first_name, last_name, exact);
+    }
+
+    void Author::id_bounds(long &min_id, long &max_id)
+    {
+        AuthorStorage::get().id_bounds(min_id, max_id);
+    }
+
+    void Author::scan_range(long from_id, long to_id, size_t batch,
+                            const std::function<bool(std::vector<Author> &)> &consumer)
+    {
+        AuthorStorage::get().scan_range(from_id, to_id, batch, consumer);
+    }
+
+    void Author::save_to_mysql()
+    {
+        AuthorStorage::get().save(*this);
+        ChangeLog::get().append(*this);
+    }
+
+    void Author::save_batch_to_mysql(Poco::Data::Session &session, std::vector<Author> &batch)
+    {
+        MySQLAuthorStorage::save_batch(session, batch);
     }
 
     long Author::get_id() const
@@ -3,7 +3,9 @@
 
 #include <string>
 #include <vector>
+#include <functional>
 #include "Poco/JSON/Object.h"
+#include "Poco/Data/Session.h"
 
 namespace database
 {
@@ -19,6 +21,9 @@ namespace database
 
             static Author fromJSON(const std::string & str);
 
+            static bool check_name(const std::string &name, std::string &reason);
+            static bool check_email(const std::string &email, std::string &reason);
+
             long             get_id() const;
             const std::string &get_first_name() const;
             const std::string &get_last_name() const;
@@ -32,10 +37,21 @@ namespace database
             std::string &title();
 
             static void init();
+            static void create_indexes();
+            static void drop_indexes();
             static Author read_by_id(long id);
+            static Author read_by_email(std::string email);
+            static long count();
             static std::vector<Author> read_all();
-            static std::vector<Author> search(std::string first_name,std::string last_name);
+            static std::vector<Author> search(std::string first_name,std::string last_name,bool exact = false);
+            static void id_bounds(long &min_id, long &max_id);
+            // reads rows with from_id < id <= to_id in id order, batch rows per fetch;
+            // scanning stops early when consumer returns false
+            static void scan_range(long from_id, long to_id, size_t batch,
+                                   const std::function<bool(std::vector<Author> &)> &consumer);
             void save_to_mysql();
+            // one multi-row INSERT for the whole batch, ids are not read back
+            static void save_batch_to_mysql(Poco::Data::Session &session, std::vector<Author> &batch);
 
             Poco::JSON::Object::Ptr toJSON() const;
 
@@ -0,0 +1,186 @@
+#include "author_stats.h"
+#include "author_storage.h"
+#include "../logger/logger.h"
+
+#include <Poco/JSON/Object.h>
+#include <Poco/JSON/Stringifier.h>
+#include <Poco/UTF8String.h>
+
+#include <chrono>
+#include <sstream>
+
+namespace database{
+    namespace {
+        long now_ms(){
+            return std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        void add_to(std::map<std::string, long> &counts, const std::string &key, long delta){
+            long &value = counts[key];
+            value += delta;
+            if (value == 0) counts.erase(key);
+        }
+
+        Poco::JSON::Object::Ptr to_object(const std::map<std::string, long> &counts){
+            Poco::JSON::Object::Ptr object = new Poco::JSON::Object();
+            for (const auto &item : counts) object->set(item.first, item.second);
+            return object;
+        }
+    }
+
+    AuthorStats::AuthorStats() : _snapshot(std::make_shared<const std::string>("{}")){
+    }
+
+    AuthorStats& AuthorStats::get(){
+        static AuthorStats _instance;
+        return _instance;
+    }
+
+    // first UTF-8 character, upper-cased
+    std::string AuthorStats::last_initial(const std::string &last_name){
+        if (last_name.empty()) return std::string();
+        unsigned char lead = static_cast<unsigned char>(last_name[0]);
+        size_t length = lead < 0x80 ? 1 : lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : 2;
+        return Poco::UTF8::toUpper(last_name.substr(0, length));
+    }
+
+    // part after the last '@', lower-cased
+    std::string AuthorStats::email_domain(const std::string &email){
+        size_t at = email.rfind('@');
+        if (at == std::string::npos) return std::string();
+        return Poco::UTF8::toLower(email.substr(at + 1));
+    }
+
+    void AuthorStats::count(AuthorCounts &counts, const std::string &initial, const std::string &domain, long delta){
+        counts.total += delta;
+        add_to(counts.by_last_initial, initial, delta);
+        add_to(counts.by_email_domain, domain, delta);
+    }
+
+    void AuthorStats::reconcile(){
+        std::lock_guard<std::mutex> serial(_reconcile_mutex);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _reconciling = true;
+            _added_during_reconcile.clear();
+        }
+        AuthorCounts counts;
+        try{
+            counts = AuthorStorage::get().aggregate(0);
+        }
+        catch (...){
+            std::lock_guard<std::mutex> lock(_mutex);
+            _reconciling = false;
+            _added_during_reconcile.clear();
+            throw;
+        }
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            // authors added while the snapshot was taken may be missing from it
+            for (const auto &item : _added_during_reconcile)
+                if (item.first > counts.max_id){
+                    count(counts, item.second.first, item.second.second, 1);
+                    counts.above.insert(item);
+                }
+            _reconciling = false;
+            _added_during_reconcile.clear();
+            if (counts.total != _counts.total)
+                Logger::get().info("author_stats", "reconciled total " + std::to_string(_counts.total) + " -> " + std::to_string(counts.total));
+            _counts = std::move(counts);
+            render();
+        }
+        _full_at_ms = now_ms();
+    }
+
+    void AuthorStats::reconcile_above(){
+        std::lock_guard<std::mutex> serial(_reconcile_mutex);
+        long from_id = 0;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            from_id = _counts.max_id;
+        }
+        AuthorCounts delta = AuthorStorage::get().aggregate(from_id);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (delta.max_id <= from_id || _counts.max_id != from_id) return;
+        // up to the new watermark the storage rows replace the authors add() counted
+        for (auto it = _counts.above.begin(); it != _counts.above.end() && it->first <= delta.max_id;){
+            count(_counts, it->second.first, it->second.second, -1);
+            it = _counts.above.erase(it);
+        }
+        _counts.total += delta.total;
+        for (const auto &item : delta.by_last_initial) add_to(_counts.by_last_initial, item.first, item.second);
+        for (const auto &item : delta.by_email_domain) add_to(_counts.by_email_domain, item.first, item.second);
+        _counts.max_id = delta.max_id;
+        render();
+    }
+
+    void AuthorStats::on_timer([[maybe_unused]] Poco::Timer &timer){
+        try{
+            if (now_ms() - _full_at_ms >= _full_interval_ms) reconcile();
+            else reconcile_above();
+        }
+        catch (std::exception &e){
+            Logger::get().warning("author_stats", std::string("reconcile failed:") + e.what());
+        }
+    }
+
+    void AuthorStats::start(long interval_ms, long full_interval_ms){
+        stop();
+        _full_interval_ms = full_interval_ms;
+        _timer.reset(new Poco::Timer(interval_ms, interval_ms));
+        _timer->start(Poco::TimerCallback<AuthorStats>(*this, &AuthorStats::on_timer));
+    }
+
+    void AuthorStats::stop(){
+        if (_timer) _timer->stop();
+        _timer.reset();
+    }
+
+    void AuthorStats::add(const Author &author){
+        std::string initial = last_initial(author.get_last_name());
+        std::string domain = email_domain(author.get_email());
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_reconciling) _added_during_reconcile.emplace(author.get_id(), std::make_pair(initial, domain));
+        if (author.get_id() <= _counts.max_id || !_counts.above.emplace(author.get_id(), std::make_pair(initial, domain)).second)
+            return;
+        count(_counts, initial, domain, 1);
+        _dirty = true;
+    }
+
+    AuthorCounts AuthorStats::counts(){
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _counts;
+    }
+
+    void AuthorStats::restore(AuthorCounts counts){
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _counts = std::move(counts);
+            render();
+        }
+        _full_at_ms = now_ms();
+    }
+
+    // caller holds _mutex
+    void AuthorStats::render(){
+        Poco::JSON::Object::Ptr root = new Poco::JSON::Object();
+        root->set("total", _counts.total);
+        root->set("by_last_initial", to_object(_counts.by_last_initial));
+        root->set("by_email_domain", to_object(_counts.by_email_domain));
+        std::ostringstream out;
+        Poco::JSON::Stringifier::stringify(root, out);
+        std::atomic_store(&_snapshot, std::shared_ptr<const std::string>(std::make_shared<const std::string>(out.str())));
+        _dirty = false;
+        _rendered_at_ms = now_ms();
+    }
+
+    std::shared_ptr<const std::string> AuthorStats::json(){
+        if (_dirty && now_ms() - _rendered_at_ms >= render_interval_ms){
+            std::unique_lock<std::mutex> lock(_mutex, std::try_to_lock);
+            if (lock.owns_lock() && _dirty) render();
+        }
+        return std::atomic_load(&_snapshot);
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef AUTHOR_STATS_H
+#define AUTHOR_STATS_H
+
+#include "author.h"
+
+#include <Poco/Timer.h>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace database{
+    // authors counted by AuthorStats::add, by id: (last initial, email domain)
+    typedef std::map<long, std::pair<std::string, std::string>> AddedAuthors;
+
+    // counts of authors that dashboards poll
+    struct AuthorCounts{
+        long total = 0;
+        std::map<std::string, long> by_last_initial;
+        std::map<std::string, long> by_email_domain;
+        // highest id in the storage snapshot the counts were taken from
+        long max_id = 0;
+        // authors above max_id counted by AuthorStats::add
+        AddedAuthors above;
+    };
+
+    // Author counters loaded from storage once, updated on every save and
+    // reconciled with storage periodically. Readers get a pre-rendered JSON
+    // snapshot that is re-rendered at most every render_interval_ms after changes.
+    //
+    // The counts cover the storage snapshot up to max_id plus every added author
+    // above it. add() ignores ids up to max_id and ids it already counted, so a
+    // save that a reconcile already saw, or a row replayed from the ChangeLog, is
+    // not counted twice. The periodic reconcile only aggregates the rows above
+    // max_id; a full pass runs rarely, it is a scan of the whole table.
+    class AuthorStats{
+        private:
+            static constexpr long render_interval_ms = 100;
+
+            std::mutex _mutex;
+            AuthorCounts _counts;
+            std::shared_ptr<const std::string> _snapshot;
+            std::atomic<bool> _dirty{false};
+            std::atomic<long> _rendered_at_ms{0};
+            std::unique_ptr<Poco::Timer> _timer;
+            // one reconcile at a time, the result is merged against the watermark it started from
+            std::mutex _reconcile_mutex;
+            long _full_interval_ms = 0;
+            std::atomic<long> _full_at_ms{0};
+            // authors added while a full pass runs, the only ones kept above its snapshot
+            bool _reconciling = false;
+            AddedAuthors _added_during_reconcile;
+
+            AuthorStats();
+            void render();
+            static void count(AuthorCounts &counts, const std::string &initial, const std::string &domain, long delta);
+            void on_timer(Poco::Timer &timer);
+        public:
+            static AuthorStats& get();
+
+            // key normalization shared by storage aggregation and incremental updates,
+            // storage groups by exact value and merges the groups with these
+            static std::string last_initial(const std::string &last_name);
+            static std::string email_domain(const std::string &email);
+
+            // replaces the counters with a fresh aggregate of the whole table
+            void reconcile();
+            // aggregates only the rows above max_id and moves the watermark up
+            void reconcile_above();
+            // reconciles the rows above max_id every interval_ms in the background,
+            // the whole table once full_interval_ms have passed since the last full pass
+            void start(long interval_ms, long full_interval_ms);
+            void stop();
+            void add(const Author &author);
+            AuthorCounts counts();
+            // replaces the counters with saved ones, see ChangeLog; they count as a full pass
+            void restore(AuthorCounts counts);
+            std::shared_ptr<const std::string> json();
+    };
+}
+#endif
@@ -0,0 +1,23 @@
+#include "author_storage.h"
+#include "mysql_author_storage.h"
+#include "memory_author_storage.h"
+#include "../config/config.h"
+
+#include <memory>
+#include <stdexcept>
+
+namespace database{
+    // the engine is chosen on first use, changing the setting afterwards is an error
+    // rather than being silently ignored
+    AuthorStorage& AuthorStorage::get(){
+        static const std::string _storage = Config::get().get_storage();
+        static std::unique_ptr<AuthorStorage> _instance = []() -> std::unique_ptr<AuthorStorage> {
+            if (_storage == "mysql") return std::make_unique<MySQLAuthorStorage>();
+            if (_storage == "memory") return std::make_unique<MemoryAuthorStorage>();
+            throw std::invalid_argument("unknown storage:" + _storage);
+        }();
+        if (Config::get().get_storage() != _storage)
+            throw std::logic_error("storage changed to " + Config::get().get_storage() + " after " + _storage + " was created");
+        return *_instance;
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef AUTHOR_STORAGE_H
+#define AUTHOR_STORAGE_H
+
+#include "author.h"
+#include "author_stats.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace database{
+    // Storage engine behind the static Author operations. The engine is chosen
+    // once by Config::get_storage(): "mysql" (default) or "memory".
+    // Lookups that find nothing throw std::logic_error("not found").
+    class AuthorStorage{
+        public:
+            virtual ~AuthorStorage() = default;
+
+            static AuthorStorage& get();
+
+            virtual void init() = 0;
+            virtual Author read_by_id(long id) = 0;
+            virtual Author read_by_email(std::string email) = 0;
+            virtual long count() = 0;
+            virtual std::vector<Author> read_all() = 0;
+            // prefix (or exact) match on both names, at most Config::get_search_limit() rows in id order;
+            // an empty name matches everything
+            virtual std::vector<Author> search(std::string first_name, std::string last_name, bool exact) = 0;
+            virtual void id_bounds(long &min_id, long &max_id) = 0;
+            virtual void scan_range(long from_id, long to_id, size_t batch,
+                                    const std::function<bool(std::vector<Author> &)> &consumer) = 0;
+            // totals of the rows with id > from_id by AuthorStats::last_initial and
+            // AuthorStats::email_domain keys; max_id is 0 when there are none
+            virtual AuthorCounts aggregate(long from_id) = 0;
+            // stores a new author and assigns its id
+            virtual void save(Author &author) = 0;
+    };
+}
+#endif
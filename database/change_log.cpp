@@ -0,0 +1,382 @@
+#include "change_log.h"
+#include "author_stats.h"
+#include "email_filter.h"
+#include "../logger/logger.h"
+
+#include <Poco/BinaryReader.h>
+#include <Poco/BinaryWriter.h>
+#include <Poco/Checksum.h>
+#include <Poco/Clock.h>
+#include <Poco/DirectoryIterator.h>
+#include <Poco/File.h>
+#include <Poco/NumberFormatter.h>
+#include <Poco/NumberParser.h>
+#include <Poco/Path.h>
+
+#include <algorithm>
+#include <sstream>
+
+namespace database{
+    namespace {
+        const std::string segment_prefix = "changes-";
+        const std::string segment_suffix = ".log";
+        constexpr Poco::UInt32 checkpoint_magic = 0x4b434c41; // "ALCK"
+        constexpr Poco::UInt32 checkpoint_version = 3;
+        constexpr Poco::UInt8 record_saved = 1;
+        constexpr Poco::UInt32 max_record = 1 << 20;
+        constexpr size_t gap_batch = 10000;
+        constexpr auto byte_order = Poco::BinaryWriter::LITTLE_ENDIAN_BYTE_ORDER;
+        constexpr auto read_order = Poco::BinaryReader::LITTLE_ENDIAN_BYTE_ORDER;
+
+        Poco::UInt32 crc32(const std::string &data){
+            Poco::Checksum crc(Poco::Checksum::TYPE_CRC32);
+            crc.update(data.data(), static_cast<unsigned>(data.size()));
+            return crc.checksum();
+        }
+
+        bool segment_number(const std::string &name, unsigned &segment){
+            if (name.size() <= segment_prefix.size() + segment_suffix.size() ||
+                name.compare(0, segment_prefix.size(), segment_prefix) != 0 ||
+                name.compare(name.size() - segment_suffix.size(), segment_suffix.size(), segment_suffix) != 0)
+                return false;
+            std::string digits = name.substr(segment_prefix.size(), name.size() - segment_prefix.size() - segment_suffix.size());
+            return Poco::NumberParser::tryParseUnsigned(digits, segment);
+        }
+
+        void write_counts(Poco::BinaryWriter &writer, const std::map<std::string, long> &counts){
+            writer << static_cast<Poco::UInt32>(counts.size());
+            for (const auto &item : counts) writer << item.first << static_cast<Poco::Int64>(item.second);
+        }
+
+        void write_above(Poco::BinaryWriter &writer, const AddedAuthors &above){
+            writer << static_cast<Poco::UInt32>(above.size());
+            for (const auto &item : above) writer << static_cast<Poco::Int64>(item.first) << item.second.first << item.second.second;
+        }
+
+        bool read_above(Poco::BinaryReader &reader, AddedAuthors &above){
+            Poco::UInt32 size = 0;
+            reader >> size;
+            for (Poco::UInt32 i = 0; i < size && reader.good(); ++i){
+                Poco::Int64 id = 0;
+                std::pair<std::string, std::string> keys;
+                reader >> id >> keys.first >> keys.second;
+                above[static_cast<long>(id)] = std::move(keys);
+            }
+            return reader.good();
+        }
+
+        bool read_counts(Poco::BinaryReader &reader, std::map<std::string, long> &counts){
+            Poco::UInt32 size = 0;
+            reader >> size;
+            for (Poco::UInt32 i = 0; i < size && reader.good(); ++i){
+                std::string key;
+                Poco::Int64 value = 0;
+                reader >> key >> value;
+                counts[key] = static_cast<long>(value);
+            }
+            return reader.good();
+        }
+    }
+
+    ChangeLog::ChangeLog(){
+    }
+
+    ChangeLog& ChangeLog::get(){
+        static ChangeLog _instance;
+        return _instance;
+    }
+
+    std::string ChangeLog::segment_path(unsigned segment) const{
+        return Poco::Path(_dir, segment_prefix + Poco::NumberFormatter::format0(segment, 8) + segment_suffix).toString();
+    }
+
+    std::string ChangeLog::checkpoint_path() const{
+        return Poco::Path(_dir, "checkpoint.bin").toString();
+    }
+
+    void ChangeLog::open(const std::string &dir, size_t segment_bytes){
+        std::lock_guard<std::mutex> lock(_mutex);
+        _dir = Poco::Path::forDirectory(dir).toString();
+        _segment_bytes = segment_bytes;
+        Poco::File(_dir).createDirectories();
+
+        // new records always go to a fresh segment after the existing ones
+        _segment = 0;
+        for (Poco::DirectoryIterator it(_dir), end; it != end; ++it){
+            unsigned segment = 0;
+            if (segment_number(it.name(), segment)) _segment = std::max(_segment, segment);
+        }
+        Logger::get().info("change_log", "dir=" + _dir + " last_segment=" + std::to_string(_segment));
+    }
+
+    void ChangeLog::open_segment(unsigned segment){
+        if (_out.is_open()) _out.close();
+        _out.clear();
+        _segment = segment;
+        _written = 0;
+        _out.open(segment_path(segment), std::ios::binary | std::ios::out | std::ios::trunc);
+        if (!_out)
+            Logger::get().error("change_log", "can't open segment " + segment_path(segment));
+    }
+
+    void ChangeLog::remove_segments_before(unsigned segment){
+        try{
+            for (Poco::DirectoryIterator it(_dir), end; it != end; ++it){
+                unsigned number = 0;
+                if (segment_number(it.name(), number) && number < segment) Poco::File(it.path()).remove();
+            }
+        }
+        catch (std::exception &e){
+            Logger::get().warning("change_log", std::string("can't remove old segments:") + e.what());
+        }
+    }
+
+    void ChangeLog::apply_state(const Author &author){
+        EmailFilter::get().add(author.get_email());
+        AuthorStats::get().add(author);
+        _last_id = std::max(_last_id, author.get_id());
+    }
+
+    void ChangeLog::append(const Author &author){
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_out.is_open()){
+            std::ostringstream payload;
+            Poco::BinaryWriter record(payload, byte_order);
+            record << record_saved << static_cast<Poco::Int64>(author.get_id()) << author.get_first_name()
+                   << author.get_last_name() << author.get_email() << author.get_title();
+            record.flush();
+            std::string data = payload.str();
+
+            Poco::BinaryWriter writer(_out, byte_order);
+            writer << static_cast<Poco::UInt32>(data.size()) << crc32(data);
+            writer.writeRaw(data);
+            writer.flush();
+            _out.flush();
+            _written += 2 * sizeof(Poco::UInt32) + data.size();
+            if (!_out){
+                // the state below still gets the author, the next checkpoint covers it
+                Logger::get().error("change_log", "write failed, logging suspended until the next checkpoint");
+                _out.close();
+            }
+            else if (_written >= _segment_bytes)
+                open_segment(_segment + 1);
+        }
+        apply_state(author);
+    }
+
+    // caller holds _mutex
+    bool ChangeLog::load_checkpoint(unsigned &first_segment){
+        Poco::File file(checkpoint_path());
+        if (!file.exists()) return false;
+
+        std::ifstream in(checkpoint_path(), std::ios::binary);
+        Poco::BinaryReader reader(in, read_order);
+        Poco::UInt32 magic = 0, version = 0, sum = 0;
+        Poco::UInt64 size = 0;
+        reader >> magic >> version >> sum >> size;
+        if (!reader.good() || magic != checkpoint_magic || version != checkpoint_version || size > file.getSize())
+            return false;
+        std::string data;
+        reader.readRaw(static_cast<std::streamsize>(size), data);
+        if (data.size() != size || crc32(data) != sum) return false;
+
+        std::istringstream payload(data);
+        Poco::BinaryReader state(payload, read_order);
+        Poco::UInt32 segment = 0;
+        Poco::Int64 last_id = 0;
+        state >> segment >> last_id;
+        if (!state.good() || !EmailFilter::get().read(state)) return false;
+
+        AuthorCounts counts;
+        Poco::Int64 total = 0, max_id = 0;
+        state >> total >> max_id;
+        counts.total = static_cast<long>(total);
+        counts.max_id = static_cast<long>(max_id);
+        if (!read_counts(state, counts.by_last_initial) || !read_counts(state, counts.by_email_domain) ||
+            !read_above(state, counts.above)) return false;
+        AuthorStats::get().restore(std::move(counts));
+
+        first_segment = segment;
+        _last_id = static_cast<long>(last_id);
+        return true;
+    }
+
+    // caller holds _mutex; a torn or corrupt record ends its segment
+    size_t ChangeLog::replay(unsigned first_segment){
+        size_t records = 0;
+        for (unsigned segment = first_segment; Poco::File(segment_path(segment)).exists(); ++segment){
+            std::ifstream in(segment_path(segment), std::ios::binary);
+            Poco::BinaryReader reader(in, read_order);
+            while (true){
+                Poco::UInt32 size = 0, sum = 0;
+                reader >> size >> sum;
+                if (!reader.good()) break;
+                std::string data;
+                if (size <= max_record) reader.readRaw(static_cast<std::streamsize>(size), data);
+                if (size > max_record || data.size() != size || crc32(data) != sum){
+                    Logger::get().warning("change_log", "damaged record in " + segment_path(segment) + ", rest of the segment skipped");
+                    break;
+                }
+
+                std::istringstream payload(data);
+                Poco::BinaryReader record(payload, read_order);
+                Poco::UInt8 type = 0;
+                Poco::Int64 id = 0;
+                Author author;
+                record >> type >> id >> author.first_name() >> author.last_name() >> author.email() >> author.title();
+                if (!record.good() || type != record_saved) continue;
+                author.id() = static_cast<long>(id);
+                apply_state(author);
+                ++records;
+            }
+        }
+        return records;
+    }
+
+    // the startup path without a usable log: full table scans
+    void ChangeLog::rebuild(){
+        _last_id = 0;
+        try{
+            long min_id = 0;
+            Author::id_bounds(min_id, _last_id);
+        }
+        catch (std::exception &e){
+            Logger::get().warning("change_log", std::string("id bounds unavailable:") + e.what());
+        }
+
+        try{
+            EmailFilter::get().load();
+        }
+        catch (std::exception &e){
+            Logger::get().warning("email_filter", std::string("disabled:") + e.what());
+        }
+
+        try{
+            AuthorStats::get().reconcile();
+        }
+        catch (std::exception &e){
+            Logger::get().warning("author_stats", std::string("initial load failed:") + e.what());
+        }
+    }
+
+    void ChangeLog::recover(){
+        if (_dir.empty()){
+            rebuild();
+            return;
+        }
+
+        Poco::Clock started;
+        bool restored = false;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            try{
+                unsigned first_segment = 0;
+                if (load_checkpoint(first_segment)){
+                    long checkpoint_id = _last_id;
+                    size_t records = replay(first_segment);
+                    long replayed_id = _last_id;
+
+                    long min_id = 0, max_id = 0;
+                    Author::id_bounds(min_id, max_id);
+                    if (max_id < _last_id)
+                        Logger::get().warning("change_log", "log is ahead of the table (last id " + std::to_string(_last_id) +
+                                                                " > " + std::to_string(max_id) + "), rebuilding");
+                    else{
+                        size_t gap = 0;
+                        if (max_id > _last_id)
+                            Author::scan_range(_last_id, max_id, gap_batch, [this, &gap](std::vector<Author> &rows){
+                                for (auto &a : rows) apply_state(a);
+                                gap += rows.size();
+                                return true;
+                            });
+                        restored = true;
+                        Logger::get().info("change_log", "recovered checkpoint_id=" + std::to_string(checkpoint_id) +
+                                                             " replayed=" + std::to_string(records) + " up_to_id=" + std::to_string(replayed_id) +
+                                                             " gap=" + std::to_string(gap) + " ms=" + std::to_string(started.elapsed() / 1000));
+                    }
+                }
+                else
+                    Logger::get().info("change_log", "no usable checkpoint, rebuilding");
+            }
+            catch (std::exception &e){
+                Logger::get().warning("change_log", std::string("recovery failed, rebuilding:") + e.what());
+            }
+        }
+
+        if (!restored){
+            rebuild();
+            Logger::get().info("change_log", "rebuilt ms=" + std::to_string(started.elapsed() / 1000));
+        }
+        checkpoint();
+    }
+
+    void ChangeLog::checkpoint(){
+        std::string data;
+        unsigned first_segment = 0;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_dir.empty()) return;
+            // records after this point go to segments the checkpoint doesn't cover
+            first_segment = _segment + 1;
+            open_segment(first_segment);
+
+            std::ostringstream payload;
+            Poco::BinaryWriter writer(payload, byte_order);
+            writer << static_cast<Poco::UInt32>(first_segment) << static_cast<Poco::Int64>(_last_id);
+            EmailFilter::get().write(writer);
+            AuthorCounts counts = AuthorStats::get().counts();
+            // the counts watermark can be above _last_id when a reconcile saw rows written
+            // without the log, replay and the gap scan must not count those again
+            writer << static_cast<Poco::Int64>(counts.total) << static_cast<Poco::Int64>(counts.max_id);
+            write_counts(writer, counts.by_last_initial);
+            write_counts(writer, counts.by_email_domain);
+            write_above(writer, counts.above);
+            writer.flush();
+            data = payload.str();
+        }
+
+        std::string temporary = checkpoint_path() + ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::out | std::ios::trunc);
+            Poco::BinaryWriter writer(out, byte_order);
+            writer << checkpoint_magic << checkpoint_version << crc32(data) << static_cast<Poco::UInt64>(data.size());
+            writer.writeRaw(data);
+            writer.flush();
+            out.flush();
+            if (!out){
+                Logger::get().error("change_log", "can't write " + temporary);
+                return;
+            }
+        }
+        Poco::File(temporary).renameTo(checkpoint_path());
+        remove_segments_before(first_segment);
+        Logger::get().debug("change_log", "checkpoint first_segment=" + std::to_string(first_segment) + " bytes=" + std::to_string(data.size()));
+    }
+
+    void ChangeLog::on_timer([[maybe_unused]] Poco::Timer &timer){
+        try{
+            checkpoint();
+        }
+        catch (std::exception &e){
+            Logger::get().warning("change_log", std::string("checkpoint failed:") + e.what());
+        }
+    }
+
+    void ChangeLog::start(long interval_ms){
+        if (_dir.empty()) return;
+        if (_timer) _timer->stop();
+        _timer.reset(new Poco::Timer(interval_ms, interval_ms));
+        _timer->start(Poco::TimerCallback<ChangeLog>(*this, &ChangeLog::on_timer));
+    }
+
+    void ChangeLog::stop(){
+        if (_timer) _timer->stop();
+        _timer.reset();
+        try{
+            checkpoint();
+        }
+        catch (std::exception &e){
+            Logger::get().warning("change_log", std::string("final checkpoint failed:") + e.what());
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef CHANGE_LOG_H
+#define CHANGE_LOG_H
+
+#include "author.h"
+
+#include <Poco/Timer.h>
+
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace database{
+    // Append-only log of saved authors that lets the in-memory state built over
+    // Author (EmailFilter, AuthorStats) survive a restart without a table scan.
+    //
+    // The log directory holds numbered segments of checksummed records and one
+    // checkpoint with the serialized state and the first segment not covered by it.
+    // Recovery loads the checkpoint, replays the later segments and reads from
+    // MySQL only the rows with id above the last one seen. Records are flushed to
+    // the OS but not synced, a tail lost with the machine is picked up by that
+    // same gap scan.
+    class ChangeLog{
+        private:
+            std::mutex _mutex;
+            std::string _dir;
+            size_t _segment_bytes = 0;
+            unsigned _segment = 0;
+            std::ofstream _out;
+            size_t _written = 0;
+            long _last_id = 0;
+            bool _open = false;
+            std::unique_ptr<Poco::Timer> _timer;
+
+            ChangeLog();
+            std::string segment_path(unsigned segment) const;
+            std::string checkpoint_path() const;
+            // caller holds _mutex
+            void open_segment(unsigned segment);
+            void remove_segments_before(unsigned segment);
+            bool load_checkpoint(unsigned &first_segment);
+            size_t replay(unsigned first_segment);
+            void apply_state(const Author &author);
+            void rebuild();
+            void on_timer(Poco::Timer &timer);
+        public:
+            static ChangeLog& get();
+
+            // uses dir for segments of about segment_bytes each; without open the
+            // log only forwards saves to the in-memory state
+            void open(const std::string &dir, size_t segment_bytes);
+            // restores EmailFilter and AuthorStats from the log, falls back to a
+            // full load when the log is missing, damaged or ahead of the table;
+            // without open it is the full load
+            void recover();
+            // logs a saved author and applies it to the in-memory state
+            void append(const Author &author);
+            // writes a checkpoint and drops the segments it covers
+            void checkpoint();
+            // checkpoints every interval_ms in the background, if open
+            void start(long interval_ms);
+            // stops the timer and leaves a final checkpoint
+            void stop();
+    };
+}
+#endif
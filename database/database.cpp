@@ -1,5 +1,9 @@
 #include "database.h"
 #include "../config/config.h"
+#include "deadline.h"
+
+#include <algorithm>
+#include <string>
 
 namespace database{
     Database::Database(){
@@ -21,7 +25,23 @@ namespace database{
     }
 
     Poco::Data::Session Database::create_session(){
-        return Poco::Data::Session(Poco::Data::SessionFactory::instance().create(Poco::Data::MySQL::Connector::KEY, _connection_string));
+        if (!Deadline::active())
+            return Poco::Data::Session(Poco::Data::SessionFactory::instance().create(Poco::Data::MySQL::Connector::KEY, _connection_string));
+
+        // connecting may take at most the rest of the request budget, statements
+        // started on the session are stopped by the server once it is spent
+        Deadline::check();
+        long remaining_ms = Deadline::remaining_ms();
+        std::size_t login_timeout = static_cast<std::size_t>((remaining_ms + 999) / 1000);
+        Poco::Data::Session session(Poco::Data::SessionFactory::instance().create(Poco::Data::MySQL::Connector::KEY, _connection_string, login_timeout));
+        Deadline::check();
+
+        remaining_ms = std::max(1L, Deadline::remaining_ms());
+        long lock_wait = std::max(1L, remaining_ms / 1000);
+        session << "SET SESSION max_execution_time=" + std::to_string(remaining_ms) +
+                   ", innodb_lock_wait_timeout=" + std::to_string(lock_wait),
+            Poco::Data::Keywords::now;
+        return session;
     }
 
 }
\ No newline at end of file
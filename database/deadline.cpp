@@ -0,0 +1,46 @@
+#include "deadline.h"
+
+#include <Poco/Exception.h>
+
+namespace database{
+    namespace {
+        thread_local bool _active = false;
+        thread_local Poco::Clock _deadline;
+    }
+
+    void Deadline::start(long timeout_ms){
+        _deadline.update();
+        _deadline += static_cast<Poco::Clock::ClockDiff>(timeout_ms) * 1000;
+        _active = true;
+    }
+
+    void Deadline::clear(){
+        _active = false;
+    }
+
+    bool Deadline::active(){
+        return _active;
+    }
+
+    bool Deadline::expired(){
+        return _active && _deadline.isElapsed(0);
+    }
+
+    long Deadline::remaining_ms(){
+        Poco::Clock::ClockDiff left = _deadline - Poco::Clock();
+        return left > 0 ? static_cast<long>(left / 1000) : 0;
+    }
+
+    void Deadline::check(){
+        if (expired()) throw Poco::TimeoutException("request deadline exceeded");
+    }
+
+    DeadlineScope::DeadlineScope(long timeout_ms){
+        if (timeout_ms > 0) Deadline::start(timeout_ms);
+        else Deadline::clear();
+    }
+
+    DeadlineScope::~DeadlineScope(){
+        Deadline::clear();
+    }
+}
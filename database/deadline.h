@@ -0,0 +1,29 @@
+#ifndef DEADLINE_H
+#define DEADLINE_H
+
+#include <Poco/Clock.h>
+
+namespace database{
+    // Deadline of the request served by the current thread. Session creation and
+    // long result loops consult it; Poco::TimeoutException reports an expired deadline.
+    class Deadline{
+        public:
+            static void start(long timeout_ms);
+            static void clear();
+            static bool active();
+            static bool expired();
+            // milliseconds left, 0 when expired; meaningless if not active
+            static long remaining_ms();
+            static void check();
+    };
+
+    // sets the deadline for the lifetime of the scope, timeout_ms <= 0 means no deadline
+    class DeadlineScope{
+        public:
+            explicit DeadlineScope(long timeout_ms);
+            ~DeadlineScope();
+            DeadlineScope(const DeadlineScope &) = delete;
+            DeadlineScope &operator=(const DeadlineScope &) = delete;
+    };
+}
+#endif
@@ -0,0 +1,258 @@
+#include "email_filter.h"
+#include "author.h"
+#include "../logger/logger.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <mutex>
+
+namespace database{
+    namespace {
+        constexpr double min_expected = 1 << 16;
+        constexpr double growth_headroom = 2.0;
+        constexpr size_t load_batch = 10000;
+        // ids are allocated before commit, so rows just below the last id seen
+        // can still appear; the rescan re-adds emails, add() only counts new ones
+        constexpr long refresh_overlap = 10000;
+
+        uint64_t fnv1a(const std::string &key){
+            uint64_t hash = 14695981039346656037ULL;
+            for (unsigned char c : key){
+                hash ^= c;
+                hash *= 1099511628211ULL;
+            }
+            return hash;
+        }
+
+        uint64_t mix(uint64_t x){
+            x ^= x >> 33;
+            x *= 0xff51afd7ed558ccdULL;
+            x ^= x >> 33;
+            x *= 0xc4ceb9fe1a85ec53ULL;
+            x ^= x >> 33;
+            return x | 1;
+        }
+    }
+
+    EmailFilter::EmailFilter(){
+    }
+
+    EmailFilter& EmailFilter::get(){
+        static EmailFilter _instance;
+        return _instance;
+    }
+
+    // Author.email uses a case-insensitive, pad-space collation: fold ASCII case and
+    // trailing spaces so the filter agrees with MySQL. Non-ASCII collation
+    // equivalences can't be reproduced here and control characters are ignored by
+    // the collation, such emails bypass the filter.
+    bool EmailFilter::normalize(const std::string &email, std::string &key){
+        key.clear();
+        key.reserve(email.size());
+        for (unsigned char c : email){
+            if (c >= 0x7f || c < 0x20) return false;
+            key += static_cast<char>(std::tolower(c));
+        }
+        while (!key.empty() && key.back() == ' ') key.pop_back();
+        return true;
+    }
+
+    void EmailFilter::build(size_t expected, double fp_rate){
+        double n = std::max(min_expected, static_cast<double>(expected) * growth_headroom);
+        double ln2 = std::log(2.0);
+        size_t bits = static_cast<size_t>(std::ceil(-n * std::log(fp_rate) / (ln2 * ln2)));
+        bits = (bits + 63) / 64 * 64;
+
+        std::unique_lock<std::shared_mutex> lock(_mutex);
+        _bit_count = bits;
+        _hash_count = std::max<size_t>(1, static_cast<size_t>(std::round(bits / n * ln2)));
+        _capacity = static_cast<size_t>(n);
+        _bits.reset(new std::atomic<uint64_t>[bits / 64]);
+        for (size_t i = 0; i < bits / 64; ++i) _bits[i].store(0, std::memory_order_relaxed);
+        _inserted = 0;
+        _ready = false;
+    }
+
+    void EmailFilter::load(){
+        long total = Author::count();
+        build(static_cast<size_t>(total), 0.01);
+
+        long min_id = 0, max_id = 0;
+        Author::id_bounds(min_id, max_id);
+        if (max_id > 0)
+            Author::scan_range(min_id - 1, max_id, load_batch, [this](std::vector<Author> &rows){
+                for (auto &a : rows) add(a.get_email());
+                return true;
+            });
+        _last_seen = max_id;
+        _ready = true;
+        Logger::get().info("email_filter", "entries=" + std::to_string(_inserted) + " bits=" + std::to_string(_bit_count) + " hashes=" + std::to_string(_hash_count));
+    }
+
+    void EmailFilter::refresh(){
+        std::lock_guard<std::mutex> lock(_refresh_mutex);
+        if (!_ready || _inserted >= _capacity){
+            load();
+            return;
+        }
+
+        long min_id = 0, max_id = 0;
+        Author::id_bounds(min_id, max_id);
+        long from_id = std::max(0L, _last_seen - refresh_overlap);
+        if (max_id > from_id)
+            Author::scan_range(from_id, max_id, load_batch, [this](std::vector<Author> &rows){
+                for (auto &a : rows) add(a.get_email());
+                return true;
+            });
+        if (max_id > _last_seen) _last_seen = max_id;
+    }
+
+    void EmailFilter::on_timer([[maybe_unused]] Poco::Timer &timer){
+        try{
+            refresh();
+        }
+        catch (std::exception &e){
+            Logger::get().warning("email_filter", std::string("refresh failed:") + e.what());
+        }
+    }
+
+    void EmailFilter::start(long interval_ms){
+        stop();
+        _timer.reset(new Poco::Timer(interval_ms, interval_ms));
+        _timer->start(Poco::TimerCallback<EmailFilter>(*this, &EmailFilter::on_timer));
+    }
+
+    void EmailFilter::stop(){
+        if (_timer) _timer->stop();
+        _timer.reset();
+    }
+
+    void EmailFilter::write(Poco::BinaryWriter &writer) const{
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+        writer << static_cast<Poco::UInt64>(_ready ? _bit_count : 0) << static_cast<Poco::UInt64>(_hash_count)
+               << static_cast<Poco::UInt64>(_capacity) << static_cast<Poco::UInt64>(_inserted)
+               << static_cast<Poco::Int64>(_last_seen);
+        if (!_ready) return;
+        for (size_t i = 0; i < _bit_count / 64; ++i)
+            writer << static_cast<Poco::UInt64>(_bits[i].load(std::memory_order_relaxed));
+    }
+
+    bool EmailFilter::read(Poco::BinaryReader &reader){
+        Poco::UInt64 bits = 0, hashes = 0, capacity = 0, inserted = 0;
+        Poco::Int64 last_seen = 0;
+        reader >> bits >> hashes >> capacity >> inserted >> last_seen;
+        if (!reader.good() || bits == 0 || bits % 64 || hashes == 0 || inserted >= capacity) return false;
+
+        std::unique_ptr<std::atomic<uint64_t>[]> words(new std::atomic<uint64_t>[bits / 64]);
+        for (size_t i = 0; i < bits / 64; ++i){
+            Poco::UInt64 word = 0;
+            reader >> word;
+            words[i].store(word, std::memory_order_relaxed);
+        }
+        if (!reader.good()) return false;
+
+        std::unique_lock<std::shared_mutex> lock(_mutex);
+        _bits = std::move(words);
+        _bit_count = static_cast<size_t>(bits);
+        _hash_count = static_cast<size_t>(hashes);
+        _capacity = static_cast<size_t>(capacity);
+        _inserted = inserted;
+        _last_seen = static_cast<long>(last_seen);
+        _ready = true;
+        return true;
+    }
+
+    bool EmailFilter::set_bits(const std::string &key){
+        uint64_t h1 = fnv1a(key);
+        uint64_t h2 = mix(h1);
+        bool changed = false;
+        for (size_t i = 0; i < _hash_count; ++i){
+            uint64_t bit = (h1 + i * h2) % _bit_count;
+            uint64_t mask = 1ULL << (bit % 64);
+            if (!(_bits[bit / 64].fetch_or(mask, std::memory_order_relaxed) & mask)) changed = true;
+        }
+        return changed;
+    }
+
+    void EmailFilter::add(const std::string &email){
+        std::string key;
+        if (!normalize(email, key)) return;
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+        // an email whose bits were all set already is not counted: re-adds from the
+        // refresh overlap or a replay don't use up capacity or skew estimated_fp_rate
+        if (!_bits || !set_bits(key)) return;
+        if (++_inserted == _capacity)
+            Logger::get().warning("email_filter", "capacity " + std::to_string(_capacity) + " reached, rebuilding on the next refresh");
+    }
+
+    bool EmailFilter::might_contain(const std::string &email) const{
+        ++_lookups;
+        std::string key;
+        if (!_ready || !normalize(email, key)){
+            ++_bypassed;
+            return true;
+        }
+
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+        uint64_t h1 = fnv1a(key);
+        uint64_t h2 = mix(h1);
+        for (size_t i = 0; i < _hash_count; ++i){
+            uint64_t bit = (h1 + i * h2) % _bit_count;
+            if (!(_bits[bit / 64].load(std::memory_order_relaxed) & (1ULL << (bit % 64)))){
+                ++_short_circuits;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void EmailFilter::report_false_positive(){
+        ++_false_positives;
+    }
+
+    uint64_t EmailFilter::lookups() const{
+        return _lookups;
+    }
+
+    uint64_t EmailFilter::short_circuits() const{
+        return _short_circuits;
+    }
+
+    uint64_t EmailFilter::bypassed() const{
+        return _bypassed;
+    }
+
+    uint64_t EmailFilter::false_positives() const{
+        return _false_positives;
+    }
+
+    // share of filter "maybe" answers that MySQL did not confirm
+    double EmailFilter::observed_fp_rate() const{
+        uint64_t maybe = _lookups - _short_circuits - _bypassed;
+        return maybe ? static_cast<double>(_false_positives) / maybe : 0.0;
+    }
+
+    double EmailFilter::estimated_fp_rate() const{
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+        if (!_bit_count) return 1.0;
+        double k = static_cast<double>(_hash_count);
+        return std::pow(1.0 - std::exp(-k * _inserted / static_cast<double>(_bit_count)), k);
+    }
+
+    bool EmailFilter::ready() const{
+        return _ready;
+    }
+
+    size_t EmailFilter::bit_count() const{
+        return _bit_count;
+    }
+
+    size_t EmailFilter::hash_count() const{
+        return _hash_count;
+    }
+
+    uint64_t EmailFilter::inserted() const{
+        return _inserted;
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef EMAIL_FILTER_H
+#define EMAIL_FILTER_H
+
+#include <Poco/BinaryReader.h>
+#include <Poco/BinaryWriter.h>
+#include <Poco/Timer.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+
+namespace database{
+    // Bloom filter over Author emails. A negative answer is exact, so most lookups
+    // of unregistered addresses never reach MySQL. Rows written by other processes
+    // (the loader, other server instances, manual SQL) are picked up by refresh().
+    class EmailFilter{
+        private:
+            std::unique_ptr<std::atomic<uint64_t>[]> _bits;
+            size_t _bit_count = 0;
+            size_t _hash_count = 0;
+            size_t _capacity = 0;
+            mutable std::shared_mutex _mutex;
+            std::atomic<bool> _ready{false};
+            std::atomic<long> _last_seen{0};
+            std::mutex _refresh_mutex;
+            std::unique_ptr<Poco::Timer> _timer;
+
+            std::atomic<uint64_t> _inserted{0};
+            mutable std::atomic<uint64_t> _lookups{0};
+            mutable std::atomic<uint64_t> _short_circuits{0};
+            mutable std::atomic<uint64_t> _bypassed{0};
+            std::atomic<uint64_t> _false_positives{0};
+
+            EmailFilter();
+            static bool normalize(const std::string &email, std::string &key);
+            // true when at least one bit was not set before
+            bool set_bits(const std::string &key);
+            void on_timer(Poco::Timer &timer);
+        public:
+            static EmailFilter& get();
+
+            // sizes the filter for expected entries at the target false positive rate
+            void build(size_t expected, double fp_rate);
+            // sizes the filter from the table count and fills it from the table
+            void load();
+            // adds rows above the last id seen, reloads when the filter is full or not loaded
+            void refresh();
+            // refreshes every interval_ms in the background
+            void start(long interval_ms);
+            void stop();
+            // geometry, insert count, last id seen and bits, as saved in a ChangeLog checkpoint
+            void write(Poco::BinaryWriter &writer) const;
+            // false when the data is not a usable filter or the filter is full
+            bool read(Poco::BinaryReader &reader);
+            void add(const std::string &email);
+            // false means the email is certainly not stored
+            bool might_contain(const std::string &email) const;
+            // the filter said "maybe" but MySQL had no such email
+            void report_false_positive();
+
+            uint64_t lookups() const;
+            uint64_t short_circuits() const;
+            uint64_t bypassed() const;
+            uint64_t false_positives() const;
+            double observed_fp_rate() const;
+            double estimated_fp_rate() const;
+            bool ready() const;
+            size_t bit_count() const;
+            size_t hash_count() const;
+            uint64_t inserted() const;
+    };
+}
+#endif
@@ -0,0 +1,170 @@
+#include "memory_author_storage.h"
+#include "../config/config.h"
+
+#include <algorithm>
+#include <cctype>
+#include <mutex>
+#include <stdexcept>
+
+namespace database{
+    MemoryAuthorStorage::Stripe &MemoryAuthorStorage::stripe(long id){
+        return _stripes[static_cast<size_t>(id) % stripe_count];
+    }
+
+    const MemoryAuthorStorage::Stripe &MemoryAuthorStorage::stripe(long id) const{
+        return _stripes[static_cast<size_t>(id) % stripe_count];
+    }
+
+    // approximates the case-insensitive column collation for ASCII text
+    std::string MemoryAuthorStorage::fold(const std::string &value){
+        std::string result(value);
+        for (auto &c : result)
+            if (static_cast<unsigned char>(c) < 0x80) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        return result;
+    }
+
+    void MemoryAuthorStorage::init(){
+        std::unique_lock<std::shared_mutex> index_lock(_index_mutex);
+        for (auto &s : _stripes){
+            std::unique_lock<std::shared_mutex> lock(s.mutex);
+            s.rows.clear();
+        }
+        _by_first_name.clear();
+        _by_last_name.clear();
+        _by_email.clear();
+        _next_id = 1;
+        _count = 0;
+    }
+
+    Author MemoryAuthorStorage::read_by_id(long id){
+        const Stripe &s = stripe(id);
+        std::shared_lock<std::shared_mutex> lock(s.mutex);
+        auto it = s.rows.find(id);
+        if (it == s.rows.end()) throw std::logic_error("not found");
+        return it->second;
+    }
+
+    Author MemoryAuthorStorage::read_by_email(std::string email){
+        long id = 0;
+        {
+            std::shared_lock<std::shared_mutex> lock(_index_mutex);
+            auto it = _by_email.find(fold(email));
+            if (it == _by_email.end()) throw std::logic_error("not found");
+            id = it->second;
+        }
+        return read_by_id(id);
+    }
+
+    long MemoryAuthorStorage::count(){
+        return _count;
+    }
+
+    std::vector<Author> MemoryAuthorStorage::read_all(){
+        std::vector<Author> result;
+        result.reserve(static_cast<size_t>(_count.load()));
+        for (const auto &s : _stripes){
+            std::shared_lock<std::shared_mutex> lock(s.mutex);
+            for (const auto &row : s.rows) result.push_back(row.second);
+        }
+        std::sort(result.begin(), result.end(), [](const Author &a, const Author &b){
+            return a.get_id() < b.get_id();
+        });
+        return result;
+    }
+
+    std::vector<Author> MemoryAuthorStorage::search(std::string first_name, std::string last_name, bool exact){
+        std::string fn = fold(first_name);
+        std::string ln = fold(last_name);
+        // scan the index of the longer prefix, filter by the other one
+        bool by_first = fn.size() >= ln.size();
+        const std::string &primary = by_first ? fn : ln;
+        const std::string &secondary = by_first ? ln : fn;
+
+        std::vector<long> ids;
+        {
+            std::shared_lock<std::shared_mutex> lock(_index_mutex);
+            const NameIndex &index = by_first ? _by_first_name : _by_last_name;
+            for (auto it = index.lower_bound(std::make_tuple(primary, std::string(), 0L));
+                 it != index.end() && std::get<0>(*it).compare(0, primary.size(), primary) == 0; ++it)
+            {
+                if (exact && !primary.empty() && std::get<0>(*it).size() != primary.size())
+                    break;
+                const std::string &other = std::get<1>(*it);
+                if (exact && !secondary.empty() ? other == secondary : other.compare(0, secondary.size(), secondary) == 0)
+                    ids.push_back(std::get<2>(*it));
+            }
+        }
+
+        size_t limit = static_cast<size_t>(std::max(0L, Config::get().get_search_limit()));
+        if (ids.size() > limit){
+            std::nth_element(ids.begin(), ids.begin() + limit, ids.end());
+            ids.resize(limit);
+        }
+        std::sort(ids.begin(), ids.end());
+        std::vector<Author> result;
+        result.reserve(ids.size());
+        for (long id : ids) result.push_back(read_by_id(id));
+        return result;
+    }
+
+    void MemoryAuthorStorage::id_bounds(long &min_id, long &max_id){
+        // ids are dense and never deleted
+        max_id = _next_id - 1;
+        min_id = max_id > 0 ? 1 : 0;
+    }
+
+    void MemoryAuthorStorage::scan_range(long from_id, long to_id, size_t batch,
+                                         const std::function<bool(std::vector<Author> &)> &consumer){
+        std::vector<Author> rows;
+        rows.reserve(batch);
+        long last_id = std::min(to_id, _next_id.load() - 1);
+        for (long id = from_id + 1; id <= last_id; ++id){
+            const Stripe &s = stripe(id);
+            {
+                std::shared_lock<std::shared_mutex> lock(s.mutex);
+                auto it = s.rows.find(id);
+                if (it == s.rows.end()) continue;
+                rows.push_back(it->second);
+            }
+            if (rows.size() == batch){
+                if (!consumer(rows)) return;
+                rows.clear();
+            }
+        }
+        if (!rows.empty()) consumer(rows);
+    }
+
+    AuthorCounts MemoryAuthorStorage::aggregate(long from_id){
+        AuthorCounts counts;
+        long last_id = _next_id - 1;
+        counts.max_id = last_id > from_id ? last_id : 0;
+        for (const auto &s : _stripes){
+            std::shared_lock<std::shared_mutex> lock(s.mutex);
+            for (const auto &row : s.rows){
+                if (row.first <= from_id || row.first > last_id) continue;
+                ++counts.total;
+                ++counts.by_last_initial[AuthorStats::last_initial(row.second.get_last_name())];
+                ++counts.by_email_domain[AuthorStats::email_domain(row.second.get_email())];
+            }
+        }
+        return counts;
+    }
+
+    void MemoryAuthorStorage::save(Author &author){
+        author.id() = _next_id++;
+        {
+            Stripe &s = stripe(author.get_id());
+            std::unique_lock<std::shared_mutex> lock(s.mutex);
+            s.rows.emplace(author.get_id(), author);
+        }
+        {
+            std::unique_lock<std::shared_mutex> lock(_index_mutex);
+            std::string fn = fold(author.get_first_name());
+            std::string ln = fold(author.get_last_name());
+            _by_first_name.emplace(fn, ln, author.get_id());
+            _by_last_name.emplace(std::move(ln), std::move(fn), author.get_id());
+            _by_email.emplace(fold(author.get_email()), author.get_id());
+        }
+        ++_count;
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef MEMORY_AUTHOR_STORAGE_H
+#define MEMORY_AUTHOR_STORAGE_H
+
+#include "author_storage.h"
+
+#include <array>
+#include <atomic>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+
+namespace database{
+    // In-process Author store for DB-free benchmarks and edge deployments.
+    // Rows live in a lock-striped hash map by id; name searches use two ordered
+    // (name, other name, id) indexes over ASCII-folded names so that a prefix on
+    // either field is a range scan. Nothing is persisted.
+    class MemoryAuthorStorage : public AuthorStorage{
+        private:
+            static constexpr size_t stripe_count = 64;
+
+            struct Stripe{
+                mutable std::shared_mutex mutex;
+                std::unordered_map<long, Author> rows;
+            };
+
+            typedef std::set<std::tuple<std::string, std::string, long>> NameIndex;
+
+            std::array<Stripe, stripe_count> _stripes;
+            std::atomic<long> _next_id{1};
+            std::atomic<long> _count{0};
+
+            mutable std::shared_mutex _index_mutex;
+            NameIndex _by_first_name;
+            NameIndex _by_last_name;
+            std::unordered_map<std::string, long> _by_email;
+
+            Stripe &stripe(long id);
+            const Stripe &stripe(long id) const;
+            static std::string fold(const std::string &value);
+
+        public:
+            void init() override;
+            Author read_by_id(long id) override;
+            Author read_by_email(std::string email) override;
+            long count() override;
+            std::vector<Author> read_all() override;
+            std::vector<Author> search(std::string first_name, std::string last_name, bool exact) override;
+            void id_bounds(long &min_id, long &max_id) override;
+            void scan_range(long from_id, long to_id, size_t batch,
+                            const std::function<bool(std::vector<Author> &)> &consumer) override;
+            AuthorCounts aggregate(long from_id) override;
+            void save(Author &author) override;
+    };
+}
+#endif
@@ -0,0 +1,619 @@
+#include "mysql_author_storage.h"
+#include "database.h"
+#include "deadline.h"
+#include "../logger/logger.h"
+#include "../config/config.h"
+
+#include <Poco/Data/MySQL/Connector.h>
+#include <Poco/Data/MySQL/MySQLException.h>
+#include <Poco/Data/SessionFactory.h>
+#include <Poco/Data/RecordSet.h>
+
+#include <exception>
+#include <set>
+
+using namespace Poco::Data::Keywords;
+using Poco::Data::Session;
+using Poco::Data::Statement;
+
+namespace database
+{
+    namespace
+    {
+        struct SearchKey
+        {
+            const char *name;
+            const char *columns;
+        };
+
+        // keys plan_search forces, tables created before them only have `fn` and `ln`
+        const SearchKey search_keys[] = {
+            {"fn_ln", "(`first_name`,`last_name`)"},
+            {"ln_fn", "(`last_name`,`first_name`)"},
+            {"em", "(`email`)"}};
+
+        // left prefixes of fn_ln and ln_fn that no plan uses, only extra work for every insert
+        const char *const legacy_keys[] = {"fn", "ln"};
+
+        std::set<std::string> existing_keys(Session &session)
+        {
+            std::vector<std::string> names;
+            session << "SELECT DISTINCT INDEX_NAME FROM information_schema.STATISTICS "
+                       "WHERE TABLE_SCHEMA=DATABASE() AND TABLE_NAME='Author'",
+                into(names), now;
+            return std::set<std::string>(names.begin(), names.end());
+        }
+    }
+
+    void MySQLAuthorStorage::init()
+    {
+        try
+        {
+
+            Poco::Data::Session session = database::Database::get().create_session();
+            //*
+            Statement drop_stmt(session);
+            drop_stmt << "DROP TABLE IF EXISTS Author", now;
+            //*/
+
+            // (re)create table
+            Statement create_stmt(session);
+            create_stmt << "CREATE TABLE IF NOT EXISTS `Author` (`id` INT NOT NULL AUTO_INCREMENT,"
+                        << "`first_name` VARCHAR(256) CHARACTER SET utf8 COLLATE utf8_unicode_ci NOT NULL,"
+                        << "`last_name` VARCHAR(256) CHARACTER SET utf8 COLLATE utf8_unicode_ci NOT NULL,"
+                        << "`email` VARCHAR(256) CHARACTER SET utf8 COLLATE utf8_unicode_ci NULL,"
+                        << "`title` VARCHAR(1024) CHARACTER SET utf8 COLLATE utf8_unicode_ci NULL,"
+                        << "PRIMARY KEY (`id`));",
+                now;
+        }
+
+        catch (Poco::Data::MySQL::ConnectionException &e)
+        {
+            Logger::get().error("connection", e.what());
+            throw;
+        }
+        catch (Poco::Data::MySQL::StatementException &e)
+        {
+
+            Logger::get().error("statement", e.what());
+            throw;
+        }
+        create_indexes();
+    }
+
+    void MySQLAuthorStorage::create_indexes()
+    {
+        try
+        {
+            Poco::Data::Session session = database::Database::get().create_session();
+            std::set<std::string> existing = existing_keys(session);
+            std::string alter;
+            for (const auto &key : search_keys)
+                if (!existing.count(key.name))
+                    alter += std::string(alter.empty() ? "" : ", ") + "ADD KEY `" + key.name + "` " + key.columns;
+            for (const char *name : legacy_keys)
+                if (existing.count(name))
+                    alter += std::string(alter.empty() ? "" : ", ") + "DROP KEY `" + name + "`";
+            if (alter.empty())
+                return;
+            Logger::get().info("schema", "altering keys: " + alter);
+            Statement create_stmt(session);
+            create_stmt << "ALTER TABLE `Author` " + alter,
+                now;
+        }
+
+        catch (Poco::Data::MySQL::ConnectionException &e)
+        {
+            Logger::get().error("connection", e.what());
+            throw;
+        }
+        catch (Poco::Data::MySQL::StatementException &e)
+        {
+
+            Logger::get().error("statement", e.what());
+            throw;
+        }
+    }
+
+    void MySQLAuthorStorage::drop_indexes()
+    {
+        try
+        {
+            Poco::Data::Session session = database::Database::get().create_session();
+            std::set<std::string> existing = existing_keys(session);
+            std::string alter;
+            for (const auto &key : search_keys)
+                if (existing.count(key.name))
+                    alter += std::string(alter.empty() ? "" : ", ") + "DROP KEY `" + key.name + "`";
+            if (alter.empty())
+                return;
+            Statement drop_stmt(session);
+            drop_stmt << "ALTER TABLE `Author` " + alter,
+                now;
+        }
+
+        catch (Poco::Data::MySQL::ConnectionException &e)
+        {
+            Logger::get().error("connection", e.what());
+            throw;
+        }
+        catch (Poco::Data::MySQL::StatementException &e)
+        {
+
+            Logger::get().error("statement", e.what());
+            throw;
+        }
+    }
+
+    Author MySQLAuthorStorage::read_by_id(long id)
+    {
+        try
+        {
+            Poco::Data::Session session = database::Database::get().create_session();
+            Poco::Data::Statement select(session);
+            Author a;
+            select << "SELECT id, first_name, last_name, email, title FROM Author where id=?",
+                into(a.id()),
+                into(a.first_name()),
+                into(a.last_name()),
+                into(a.email()),
+                into(a.title()),
+                use(id),
+                range(0, 1); //  iterate over result set one row at a time
+            select.execute();
+            Poco::Data::RecordSet rs(select);
+            if (!rs.moveFirst()) throw std::logic_error("not found");
+
+            return a;
+        }
+
+        catch (Poco::Data::MySQL::ConnectionException &e)
+        {
+            Logger::get().error("connection", e.what());
+            throw;
+        }
+        catch (Poco::Data::MySQL::StatementException &e)
+        {
+
+            Logger::get().error("statement", e.what());
+            throw;
+        }
+    }
+
+    Author MySQLAuthorStorage::read_by_email(std::string email)
+    {
+        try
+        {
+            Poco::Data::Session session = database::Database::get().create_session();
+            Poco::Data::Statement select(session);
+            Author a;
+            select << "SELECT id, first_name, last_name, email, title FROM Author where email=? LIMIT 1",
+                into(a.id()),
+                into(a.first_name()),
+                into(a.last_name()),
+                into(a.email()),
+                into(a.title()),
+                use(email),
+                range(0, 1); //  iterate over result set one row at a time
+            select.execute();
+            Poco::Data::RecordSet rs(select);
+            if (!rs.moveFirst()) throw std::logic_error("not found");
+
+            return a;
+        }
+
+        catch (Poco::Data::MySQL::ConnectionException &e)
+        {
+            Logger::get().error("connection", e.what());
+            throw;
+        }
+        catch (Poco::Data::MySQL::StatementException &e)
+        {
+
+            Logger::get().error("statement", e.what());
+            throw;
+        }
+    }
+
+    long MySQLAuthorStorage::count()
+    {
+        try
+        {
+            Poco::Data::Session session = database::Database::get().create_session();
+            Statement select(session);
+            long total = 0;
+            select << "SELECT COUNT(*) FROM Author",
+                into(total),
+                now;
+            return total;
+        }
+
+        catch (Poco::Data::MySQL::ConnectionException &e)
+        {
+            Logger::get().error("connection", e.what());
+            throw;
+        }
+        catch (Poco::Data::MySQL::StatementException &e)
+        {
+
+            Logger::get().error("statement", e.what());
+            throw;
+        }
+    }
+
+    std::vector<Author> MySQLAuthorStorage::read_all()
+    {
+        try
+        {
+            Poco::Data::Session session = database::Database::get().create_session();
+            Statement select(session);
+            std::vector<Author> result;
+            Author a;
+            select << "SELECT id, first_name, last_name, email, title FROM Author",
+                into(a.id()),
+                into(a.first_name()),
+                into(a.last_name()),
+                into(a.email()),
+                into(a.title()),
+                range(0, 1); //  iterate over result set one row at a time
+
+            while (!select.done())
+            {
+                Deadline::check();
+                select.execute();
+                result.push_back(a);
+            }
+            return result;
+        }
+
+        catch (Poco::Data::MySQL::ConnectionException &e)
+        {
+            Logger::get().error("connection", e.what());
+            throw;
+        }
+        catch (Poco::Data::MySQL::StatementException &e)
+        {
+
+            Logger::get().error("statement", e.what());
+            throw;
+        }
+    }
+
+    namespace
+    {
+        // LIKE pattern matching value literally followed by any suffix
+        std::string like_prefix(const std::string &value)
+        {
+            std::string pattern;
+            pattern.reserve(value.size() + 1);
+            for (char c : value)
+            {
+                if (c == '%' || c == '_' || c == '\\')
+                    pattern += '\\';
+                pattern += c;
+            }
+            pattern += '%';
+            return pattern;
+        }
+    }
+
+    // The name filters only ever constrain a leading part of the fields, so each
+    // plan is a range on fn_ln or ln_fn. The inner query reads ids from that
+    // index alone (InnoDB secondary keys carry the primary key), applies the cap
+    // in id order, and only the capped ids are joined back to the rows.
+    MySQLAuthorStorage::SearchPlan MySQLAuthorStorage::plan_search(const std::string &first_name, const std::string &last_name, bool exact)
+    {
+        static const std::string columns = "SELECT a.id, a.first_name, a.last_name, a.email, a.title FROM Author a ";
+        static const std::string order = " ORDER BY a.id";
+        SearchPlan plan;
+
+        if (first_name.empty() && last_name.empty())
+        {
+            plan.name = "all";
+            plan.sql = columns + "ORDER BY a.id LIMIT ?";
+            return plan;
+        }
+
+        // lead with the field that narrows the range most: exact beats prefix, longer prefix beats shorter
+        bool lead_first = last_name.empty() || (!first_name.empty() && first_name.size() >= last_name.size());
+        const std::string &lead = lead_first ? first_name : last_name;
+        const std::string &other = lead_first ? last_name : first_name;
+        std::string lead_column = lead_first ? "first_name" : "last_name";
+        std::string other_column = lead_first ? "last_name" : "first_name";
+        std::string index = lead_first ? "fn_ln" : "ln_fn";
+        std::string op = exact ? " = ?" : " LIKE ?";
+
+        std::string where = lead_column + op;
+        plan.params.push_back(exact ? lead : like_prefix(lead));
+        if (!other.empty())
+        {
+            where += " AND " + other_column + op;
+            plan.params.push_back(exact ? other : like_prefix(other));
+        }
+
+        plan.name = std::string(exact ? "exact" : "prefix") + (other.empty() ? "_" : "_both_") + index;
+        plan.sql = columns + "JOIN (SELECT id FROM Author FORCE INDEX (`" + index + "`) WHERE " + where +
+                   " ORDER BY id LIMIT ?) k ON a.id = k.id" + order;
+        return plan;
+    }
+
+    std::vector<Author> MySQLAuthorStorage::search(std::string first_name, std::string last_name, bool exact)
+    {
+        try
+        {
+            Poco::Data::Session session = database::Database::get().create_session();
+            SearchPlan plan = plan_search(first_name, last_name, exact);
+            long limit = Config::get().get_search_limit();
+            std::vector<long> ids;
+            std::vector<std::string> first_names, last_names, emails, titles;
+
+            Deadline::check();
+            Statement select(session);
+            select << plan.sql,
+                into(ids),
+                into(first_names),
+                into(last_names),
+                into(emails),
+                into(titles);
+            for (auto &param : plan.params)
+                select.addBind(use(param));
+            select.addBind(use(limit));
+            select.execute();
+
+            std::vector<Author> result(ids.size());
+            for (size_t i = 0; i < ids.size(); ++i)
+            {
+                result[i].id() = ids[i];
+                result[i].first_name().swap(first_names[i]);
+                result[i].last_name().swap(last_names[i]);
+                result[i].email().swap(emails[i]);
+                result[i].title().swap(titles[i]);
+            }
+            return result;
+        }
+
+        catch (Poco::Data::MySQL::ConnectionException &e)
+        {
+            Logger::get().error("connection", e.what());
+            throw;
+        }
+        catch (Poco::Data::MySQL::StatementException &e)
+        {
+
+            Logger::get().error("statement", e.what());
+            throw;
+        }
+    }
+
+    void MySQLAuthorStorage::id_bounds(long &min_id, long &max_id)
+    {
+        try
+        {
+            Poco::Data::Session session = database::Database::get().create_session();
+            Statement select(session);
+            min_id = 0;
+            max_id = 0;
+            select << "SELECT COALESCE(MIN(id),0), COALESCE(MAX(id),0) FROM Author",
+                into(min_id),
+                into(max_id),
+                now;
+        }
+
+        catch (Poco::Data::MySQL::ConnectionException &e)
+        {
+            Logger::get().error("connection", e.what());
+            throw;
+        }
+        catch (Poco::Data::MySQL::StatementException &e)
+        {
+
+            Logger::get().error("statement", e.what());
+            throw;
+        }
+    }
+
+    void MySQLAuthorStorage::scan_range(long from_id, long to_id, size_t batch,
+                                        const std::function<bool(std::vector<Author> &)> &consumer)
+    {
+        try
+        {
+            Poco::Data::Session session = database::Database::get().create_session();
+            long last_id = from_id;
+            long upper_id = to_id;
+            long limit = static_cast<long>(batch);
+            std::vector<long> ids;
+            std::vector<std::string> first_names, last_names, emails, titles;
+            std::vector<Author> rows;
+
+            // keyset pagination: every fetch is a primary key range read of at most batch rows
+            while (last_id < upper_id)
+            {
+                Deadline::check();
+                ids.clear();
+                first_names.clear();
+                last_names.clear();
+                emails.clear();
+                titles.clear();
+
+                Statement select(session);
+                select << "SELECT id, first_name, last_name, email, title FROM Author where id>? and id<=? ORDER BY id LIMIT ?",
+                    into(ids),
+                    into(first_names),
+                    into(last_names),
+                    into(emails),
+                    into(titles),
+                    use(last_id),
+                    use(upper_id),
+                    use(limit),
+                    now;
+
+                if (ids.empty())
+                    break;
+
+                rows.resize(ids.size());
+                for (size_t i = 0; i < ids.size(); ++i)
+                {
+                    rows[i].id() = ids[i];
+                    rows[i].first_name().swap(first_names[i]);
+                    rows[i].last_name().swap(last_names[i]);
+                    rows[i].email().swap(emails[i]);
+                    rows[i].title().swap(titles[i]);
+                }
+
+                last_id = ids.back();
+                if (!consumer(rows))
+                    break;
+                if (ids.size() < batch)
+                    break;
+            }
+        }
+
+        catch (Poco::Data::MySQL::ConnectionException &e)
+        {
+            Logger::get().error("connection", e.what());
+            throw;
+        }
+        catch (Poco::Data::MySQL::StatementException &e)
+        {
+
+            Logger::get().error("statement", e.what());
+            throw;
+        }
+    }
+
+    AuthorCounts MySQLAuthorStorage::aggregate(long from_id)
+    {
+        try
+        {
+            Poco::Data::Session session = database::Database::get().create_session();
+            AuthorCounts counts;
+            std::vector<std::string> keys;
+            std::vector<long> totals;
+
+            // one consistent snapshot for the total, the groups and the id watermark
+            session.begin();
+            // id > from_id is a primary key range, periodic passes only read the new rows
+            session << "SELECT COUNT(*), COALESCE(MAX(id),0) FROM Author WHERE id > ?",
+                into(counts.total),
+                into(counts.max_id),
+                use(from_id),
+                now;
+
+            // exact groups, the collation would merge case and accent variants
+            // under an arbitrary representative; keys are folded and merged here
+            session << "SELECT LEFT(last_name,1) COLLATE utf8_bin AS initial, COUNT(*) FROM Author WHERE id > ? GROUP BY initial",
+                into(keys),
+                into(totals),
+                use(from_id),
+                now;
+            for (size_t i = 0; i < keys.size(); ++i)
+                counts.by_last_initial[AuthorStats::last_initial(keys[i])] += totals[i];
+
+            keys.clear();
+            totals.clear();
+            session << "SELECT CONCAT('@', SUBSTRING_INDEX(email,'@',-1)) COLLATE utf8_bin AS domain, COUNT(*) FROM Author "
+                    << "WHERE id > ? AND email LIKE '%@%' GROUP BY domain",
+                into(keys),
+                into(totals),
+                use(from_id),
+                now;
+            session.commit();
+            long with_domain = 0;
+            for (size_t i = 0; i < keys.size(); ++i)
+            {
+                counts.by_email_domain[AuthorStats::email_domain(keys[i])] += totals[i];
+                with_domain += totals[i];
+            }
+            if (counts.total > with_domain)
+                counts.by_email_domain[std::string()] += counts.total - with_domain;
+            return counts;
+        }
+
+        catch (Poco::Data::MySQL::ConnectionException &e)
+        {
+            Logger::get().error("connection", e.what());
+            throw;
+        }
+        catch (Poco::Data::MySQL::StatementException &e)
+        {
+
+            Logger::get().error("statement", e.what());
+            throw;
+        }
+    }
+
+    void MySQLAuthorStorage::save(Author &author)
+    {
+
+        try
+        {
+            Poco::Data::Session session = database::Database::get().create_session();
+            Poco::Data::Statement insert(session);
+
+            insert << "INSERT INTO Author (first_name,last_name,email,title) VALUES(?, ?, ?, ?)",
+                use(author.first_name()),
+                use(author.last_name()),
+                use(author.email()),
+                use(author.title());
+
+            insert.execute();
+
+            Poco::Data::Statement select(session);
+            select << "SELECT LAST_INSERT_ID()",
+                into(author.id()),
+                range(0, 1); //  iterate over result set one row at a time
+
+            if (!select.done())
+            {
+                select.execute();
+            }
+            if (Logger::get().enabled(LogLevel::Debug))
+                Logger::get().debug("author", "inserted:" + std::to_string(author.get_id()));
+        }
+        catch (Poco::Data::MySQL::ConnectionException &e)
+        {
+            Logger::get().error("connection", e.what());
+            throw;
+        }
+        catch (Poco::Data::MySQL::StatementException &e)
+        {
+
+            Logger::get().error("statement", e.what());
+            throw;
+        }
+    }
+
+    void MySQLAuthorStorage::save_batch(Poco::Data::Session &session, std::vector<Author> &batch)
+    {
+        if (batch.empty())
+            return;
+        try
+        {
+            std::string sql = "INSERT INTO Author (first_name,last_name,email,title) VALUES ";
+            for (size_t i = 0; i < batch.size(); ++i)
+                sql += (i == 0) ? "(?, ?, ?, ?)" : ",(?, ?, ?, ?)";
+
+            Poco::Data::Statement insert(session);
+            insert << sql;
+            for (auto &a : batch)
+            {
+                insert.addBind(use(a.first_name()));
+                insert.addBind(use(a.last_name()));
+                insert.addBind(use(a.email()));
+                insert.addBind(use(a.title()));
+            }
+            insert.execute();
+        }
+        catch (Poco::Data::MySQL::ConnectionException &e)
+        {
+            Logger::get().error("connection", e.what());
+            throw;
+        }
+        catch (Poco::Data::MySQL::StatementException &e)
+        {
+
+            Logger::get().error("statement", e.what());
+            throw;
+        }
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef MYSQL_AUTHOR_STORAGE_H
+#define MYSQL_AUTHOR_STORAGE_H
+
+#include "author_storage.h"
+
+#include <Poco/Data/Session.h>
+
+namespace database{
+    class MySQLAuthorStorage : public AuthorStorage{
+        public:
+            void init() override;
+            Author read_by_id(long id) override;
+            Author read_by_email(std::string email) override;
+            long count() override;
+            std::vector<Author> read_all() override;
+            std::vector<Author> search(std::string first_name, std::string last_name, bool exact) override;
+            void id_bounds(long &min_id, long &max_id) override;
+            void scan_range(long from_id, long to_id, size_t batch,
+                            const std::function<bool(std::vector<Author> &)> &consumer) override;
+            AuthorCounts aggregate(long from_id) override;
+            void save(Author &author) override;
+
+            struct SearchPlan{
+                std::string name;
+                std::string sql;
+                // values for the filter placeholders, the LIMIT placeholder follows them
+                std::vector<std::string> params;
+            };
+            static SearchPlan plan_search(const std::string &first_name, const std::string &last_name, bool exact);
+
+            // schema and bulk operations that only exist for MySQL; the index
+            // operations only touch the keys that are missing or present
+            static void create_indexes();
+            static void drop_indexes();
+            static void save_batch(Poco::Data::Session &session, std::vector<Author> &batch);
+    };
+}
+#endif
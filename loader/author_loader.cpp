@@ -0,0 +1,485 @@
+#include "../config/config.h"
+#include "../database/database.h"
+#include "../database/author.h"
+
+#include "Poco/File.h"
+#include "Poco/SharedMemory.h"
+#include "Poco/Timestamp.h"
+#include "Poco/JSON/Parser.h"
+#include "Poco/Util/Application.h"
+#include "Poco/Util/Option.h"
+#include "Poco/Util/OptionSet.h"
+#include "Poco/Util/HelpFormatter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using Poco::Timestamp;
+using Poco::Util::Application;
+using Poco::Util::HelpFormatter;
+using Poco::Util::Option;
+using Poco::Util::OptionCallback;
+using Poco::Util::OptionSet;
+
+namespace
+{
+    // a prepared statement takes at most 65535 placeholders, save_batch_to_mysql binds 4 per row
+    constexpr size_t max_batch = 65535 / 4;
+
+    // column positions of first_name, last_name, email, title in a CSV line
+    struct CsvLayout
+    {
+        int first_name = 0;
+        int last_name = 1;
+        int email = 2;
+        int title = 3;
+    };
+
+    void split_csv(std::string_view line, std::vector<std::string> &fields)
+    {
+        fields.clear();
+        fields.emplace_back();
+        bool quoted = false;
+        for (size_t i = 0; i < line.size(); ++i)
+        {
+            char c = line[i];
+            if (quoted)
+            {
+                if (c == '"' && i + 1 < line.size() && line[i + 1] == '"')
+                {
+                    fields.back() += '"';
+                    ++i;
+                }
+                else if (c == '"')
+                    quoted = false;
+                else
+                    fields.back() += c;
+            }
+            else if (c == '"')
+                quoted = true;
+            else if (c == ',')
+                fields.emplace_back();
+            else
+                fields.back() += c;
+        }
+    }
+
+    bool parse_layout(std::string_view line, CsvLayout &layout)
+    {
+        std::vector<std::string> names;
+        split_csv(line, names);
+        CsvLayout result{-1, -1, -1, -1};
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            if (names[i] == "first_name")
+                result.first_name = static_cast<int>(i);
+            else if (names[i] == "last_name")
+                result.last_name = static_cast<int>(i);
+            else if (names[i] == "email")
+                result.email = static_cast<int>(i);
+            else if (names[i] == "title")
+                result.title = static_cast<int>(i);
+        }
+        if (result.first_name < 0 || result.last_name < 0 || result.email < 0 || result.title < 0)
+            return false;
+        layout = result;
+        return true;
+    }
+
+    // end of the record starting at pos: the next newline, for csv the next one outside quotes
+    const char *record_end(const char *pos, const char *end, bool csv)
+    {
+        if (!csv)
+        {
+            const char *eol = static_cast<const char *>(memchr(pos, '\n', end - pos));
+            return eol ? eol : end;
+        }
+        bool quoted = false;
+        for (; pos < end; ++pos)
+        {
+            if (*pos == '"')
+                quoted = !quoted;
+            else if (*pos == '\n' && !quoted)
+                return pos;
+        }
+        return end;
+    }
+
+    // start of the first record at or after target; prev is a record start before target
+    const char *record_boundary(const char *prev, const char *target, const char *end, bool csv)
+    {
+        bool quoted = false;
+        if (csv)
+            for (const char *quote = prev; quote < target && (quote = static_cast<const char *>(memchr(quote, '"', target - quote))); ++quote)
+                quoted = !quoted;
+        for (const char *pos = target; pos < end; ++pos)
+        {
+            if (csv && *pos == '"')
+                quoted = !quoted;
+            else if (*pos == '\n' && !quoted)
+                return pos + 1;
+        }
+        return end;
+    }
+
+    std::string_view trim_line(std::string_view line)
+    {
+        while (!line.empty() && (line.back() == '\r' || line.back() == '\n'))
+            line.remove_suffix(1);
+        return line;
+    }
+}
+
+class AuthorLoader : public Poco::Util::Application
+{
+public:
+    AuthorLoader() : _helpRequested(false), _initDB(false), _dropIndexes(false),
+                     _threads(std::max(1u, std::thread::hardware_concurrency())), _batch(500)
+    {
+    }
+
+protected:
+    void defineOptions(OptionSet &options)
+    {
+        Application::defineOptions(options);
+
+        options.addOption(
+            Option("help", "h", "display argument help information")
+                .required(false)
+                .repeatable(false)
+                .callback(OptionCallback<AuthorLoader>(this, &AuthorLoader::handleHelp)));
+        options.addOption(
+            Option("host", "ho", "set ip address for dtabase")
+                .required(false)
+                .repeatable(false)
+                .argument("value")
+                .callback(OptionCallback<AuthorLoader>(this, &AuthorLoader::handleHost)));
+        options.addOption(
+            Option("port", "po", "set mysql port")
+                .required(false)
+                .repeatable(false)
+                .argument("value")
+                .callback(OptionCallback<AuthorLoader>(this, &AuthorLoader::handlePort)));
+        options.addOption(
+            Option("login", "lg", "set mysql login")
+                .required(false)
+                .repeatable(false)
+                .argument("value")
+                .callback(OptionCallback<AuthorLoader>(this, &AuthorLoader::handleLogin)));
+        options.addOption(
+            Option("password", "pw", "set mysql password")
+                .required(false)
+                .repeatable(false)
+                .argument("value")
+                .callback(OptionCallback<AuthorLoader>(this, &AuthorLoader::handlePassword)));
+        options.addOption(
+            Option("database", "db", "set mysql database")
+                .required(false)
+                .repeatable(false)
+                .argument("value")
+                .callback(OptionCallback<AuthorLoader>(this, &AuthorLoader::handleDatabase)));
+        options.addOption(
+            Option("init_db", "it", "create database tables before loading")
+                .required(false)
+                .repeatable(false)
+                .callback(OptionCallback<AuthorLoader>(this, &AuthorLoader::handleInitDB)));
+        options.addOption(
+            Option("file", "f", "csv or ndjson file with authors")
+                .required(false)
+                .repeatable(false)
+                .argument("path")
+                .callback(OptionCallback<AuthorLoader>(this, &AuthorLoader::handleFile)));
+        options.addOption(
+            Option("format", "fm", "input format: csv or ndjson (default by file extension)")
+                .required(false)
+                .repeatable(false)
+                .argument("value")
+                .callback(OptionCallback<AuthorLoader>(this, &AuthorLoader::handleFormat)));
+        options.addOption(
+            Option("threads", "th", "number of parallel loader sessions")
+                .required(false)
+                .repeatable(false)
+                .argument("value")
+                .callback(OptionCallback<AuthorLoader>(this, &AuthorLoader::handleThreads)));
+        options.addOption(
+            Option("batch", "b", "rows per multi-row insert, at most 16383")
+                .required(false)
+                .repeatable(false)
+                .argument("value")
+                .callback(OptionCallback<AuthorLoader>(this, &AuthorLoader::handleBatch)));
+        options.addOption(
+            Option("drop_indexes", "di", "drop secondary indexes while loading and rebuild them afterwards")
+                .required(false)
+                .repeatable(false)
+                .callback(OptionCallback<AuthorLoader>(this, &AuthorLoader::handleDropIndexes)));
+    }
+
+    void handleInitDB([[maybe_unused]] const std::string &name,
+                      [[maybe_unused]] const std::string &value)
+    {
+        _initDB = true;
+    }
+    void handleDropIndexes([[maybe_unused]] const std::string &name,
+                           [[maybe_unused]] const std::string &value)
+    {
+        _dropIndexes = true;
+    }
+    void handleLogin([[maybe_unused]] const std::string &name,
+                     [[maybe_unused]] const std::string &value)
+    {
+        Config::get().login() = value;
+    }
+    void handlePassword([[maybe_unused]] const std::string &name,
+                        [[maybe_unused]] const std::string &value)
+    {
+        Config::get().password() = value;
+    }
+    void handleDatabase([[maybe_unused]] const std::string &name,
+                        [[maybe_unused]] const std::string &value)
+    {
+        Config::get().database() = value;
+    }
+    void handlePort([[maybe_unused]] const std::string &name,
+                    [[maybe_unused]] const std::string &value)
+    {
+        Config::get().port() = value;
+    }
+    void handleHost([[maybe_unused]] const std::string &name,
+                    [[maybe_unused]] const std::string &value)
+    {
+        Config::get().host() = value;
+    }
+    void handleFile([[maybe_unused]] const std::string &name,
+                    [[maybe_unused]] const std::string &value)
+    {
+        _file = value;
+    }
+    void handleFormat([[maybe_unused]] const std::string &name,
+                      [[maybe_unused]] const std::string &value)
+    {
+        _format = value;
+    }
+    void handleThreads([[maybe_unused]] const std::string &name,
+                       [[maybe_unused]] const std::string &value)
+    {
+        _threads = std::max(1, atoi(value.c_str()));
+    }
+    void handleBatch([[maybe_unused]] const std::string &name,
+                     [[maybe_unused]] const std::string &value)
+    {
+        _batch = std::min(max_batch, static_cast<size_t>(std::max(1, atoi(value.c_str()))));
+    }
+
+    void handleHelp([[maybe_unused]] const std::string &name,
+                    [[maybe_unused]] const std::string &value)
+    {
+        HelpFormatter helpFormatter(options());
+        helpFormatter.setCommand(commandName());
+        helpFormatter.setUsage("OPTIONS");
+        helpFormatter.setHeader(
+            "Bulk loader for Author datasets in csv or ndjson format.");
+        helpFormatter.format(std::cout);
+        stopOptionsProcessing();
+        _helpRequested = true;
+    }
+
+    // parses [begin,end) record by record and inserts valid rows in batches on its own session
+    void load_chunk(const char *begin, const char *end, bool csv, const CsvLayout &layout)
+    {
+        Poco::Data::Session session = database::Database::get().create_session();
+        if (_dropIndexes)
+            session << "SET unique_checks=0", Poco::Data::Keywords::now;
+
+        std::vector<database::Author> batch;
+        batch.reserve(_batch);
+        std::vector<std::string> fields;
+        Poco::JSON::Parser parser;
+        std::string reason;
+
+        auto flush = [&]() {
+            if (batch.empty())
+                return;
+            session.begin();
+            database::Author::save_batch_to_mysql(session, batch);
+            session.commit();
+            _loaded += batch.size();
+            batch.clear();
+        };
+
+        const char *pos = begin;
+        while (pos < end)
+        {
+            const char *eol = record_end(pos, end, csv);
+            std::string_view line = trim_line(std::string_view(pos, eol - pos));
+            pos = eol + 1;
+            if (line.empty())
+                continue;
+
+            database::Author author;
+            author.id() = 0;
+            try
+            {
+                if (csv)
+                {
+                    split_csv(line, fields);
+                    int columns = static_cast<int>(fields.size());
+                    if (columns <= std::max({layout.first_name, layout.last_name, layout.email, layout.title}))
+                    {
+                        ++_rejected;
+                        continue;
+                    }
+                    author.first_name() = std::move(fields[layout.first_name]);
+                    author.last_name() = std::move(fields[layout.last_name]);
+                    author.email() = std::move(fields[layout.email]);
+                    author.title() = std::move(fields[layout.title]);
+                }
+                else
+                {
+                    parser.reset();
+                    Poco::JSON::Object::Ptr object = parser.parse(std::string(line)).extract<Poco::JSON::Object::Ptr>();
+                    author.first_name() = object->getValue<std::string>("first_name");
+                    author.last_name() = object->getValue<std::string>("last_name");
+                    author.email() = object->getValue<std::string>("email");
+                    author.title() = object->getValue<std::string>("title");
+                }
+            }
+            catch (Poco::Exception &)
+            {
+                ++_rejected;
+                continue;
+            }
+
+            if (!database::Author::check_name(author.get_first_name(), reason) ||
+                !database::Author::check_name(author.get_last_name(), reason) ||
+                !database::Author::check_email(author.get_email(), reason))
+            {
+                ++_rejected;
+                continue;
+            }
+
+            batch.push_back(std::move(author));
+            if (batch.size() >= _batch)
+                flush();
+        }
+        flush();
+    }
+
+    int main([[maybe_unused]] const std::vector<std::string> &args)
+    {
+        if (_helpRequested)
+            return Application::EXIT_OK;
+        if (_file.empty())
+        {
+            std::cout << "file is not set" << std::endl;
+            return Application::EXIT_USAGE;
+        }
+        if (_format.empty())
+            _format = (_file.size() > 4 && _file.compare(_file.size() - 4, 4, ".csv") == 0) ? "csv" : "ndjson";
+        if (_format != "csv" && _format != "ndjson")
+        {
+            std::cout << "format must be csv or ndjson" << std::endl;
+            return Application::EXIT_USAGE;
+        }
+        bool csv = (_format == "csv");
+
+        if (_initDB)
+        {
+            std::cout << "init db" << std::endl;
+            database::Author::init();
+        }
+
+        Poco::File file(_file);
+        if (!file.exists() || file.getSize() == 0)
+        {
+            std::cout << "file is empty or missing:" << _file << std::endl;
+            return Application::EXIT_NOINPUT;
+        }
+
+        Poco::SharedMemory mapped(file, Poco::SharedMemory::AM_READ);
+        const char *begin = mapped.begin();
+        const char *end = mapped.end();
+
+        CsvLayout layout;
+        if (csv)
+        {
+            const char *eol = record_end(begin, end, csv);
+            std::string_view first = trim_line(std::string_view(begin, eol - begin));
+            if (parse_layout(first, layout))
+                begin = eol < end ? eol + 1 : end;
+        }
+
+        if (_dropIndexes)
+            database::Author::drop_indexes();
+
+        // cut the mapping into one chunk per thread on record boundaries, quoted
+        // csv fields may contain newlines
+        std::vector<const char *> cuts{begin};
+        size_t step = (end - begin) / _threads + 1;
+        for (size_t i = 1; i < _threads; ++i)
+        {
+            const char *cut = std::max(cuts.back(), std::min(end, begin + i * step));
+            cuts.push_back(record_boundary(cuts.back(), cut, end, csv));
+        }
+        cuts.push_back(end);
+
+        Timestamp started;
+        std::atomic<bool> failed{false};
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i + 1 < cuts.size(); ++i)
+        {
+            if (cuts[i] >= cuts[i + 1])
+                continue;
+            workers.emplace_back([this, &cuts, &failed, &layout, i, csv]() {
+                try
+                {
+                    load_chunk(cuts[i], cuts[i + 1], csv, layout);
+                }
+                catch (std::exception &e)
+                {
+                    std::cout << "loader:" << e.what() << std::endl;
+                    failed = true;
+                }
+            });
+        }
+        for (auto &worker : workers)
+            worker.join();
+        double load_seconds = static_cast<double>(started.elapsed()) / 1000000.0;
+
+        if (_dropIndexes)
+        {
+            Timestamp rebuild;
+            database::Author::create_indexes();
+            std::cout << "indexes rebuilt in " << static_cast<double>(rebuild.elapsed()) / 1000000.0 << " s" << std::endl;
+        }
+
+        double seconds = static_cast<double>(started.elapsed()) / 1000000.0;
+        std::cout << "loaded:" << _loaded
+                  << " rejected:" << _rejected
+                  << " threads:" << workers.size()
+                  << " seconds:" << seconds
+                  << " rows/s:" << (load_seconds > 0 ? _loaded / load_seconds : 0.0)
+                  << " rows/s (with index rebuild):" << (seconds > 0 ? _loaded / seconds : 0.0)
+                  << std::endl;
+
+        return failed ? Application::EXIT_SOFTWARE : Application::EXIT_OK;
+    }
+
+private:
+    bool _helpRequested;
+    bool _initDB;
+    bool _dropIndexes;
+    size_t _threads;
+    size_t _batch;
+    std::string _file;
+    std::string _format;
+    std::atomic<size_t> _loaded{0};
+    std::atomic<size_t> _rejected{0};
+};
+
+POCO_APP_MAIN(AuthorLoader)
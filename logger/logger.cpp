@@ -0,0 +1,290 @@
+#include "logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+
+namespace
+{
+    std::atomic<uint64_t> next_thread_id{1};
+
+    int64_t now_us()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    }
+
+    const char *level_name(LogLevel level)
+    {
+        switch (level)
+        {
+        case LogLevel::Debug:
+            return "debug";
+        case LogLevel::Info:
+            return "info";
+        case LogLevel::Warning:
+            return "warning";
+        case LogLevel::Error:
+            return "error";
+        }
+        return "info";
+    }
+
+    void append_time(std::string &out, int64_t timestamp_us)
+    {
+        std::time_t seconds = static_cast<std::time_t>(timestamp_us / 1000000);
+        std::tm tm;
+        gmtime_r(&seconds, &tm);
+        char buffer[40];
+        size_t n = std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &tm);
+        n += std::snprintf(buffer + n, sizeof(buffer) - n, ".%06dZ", static_cast<int>(timestamp_us % 1000000));
+        out.append(buffer, n);
+    }
+
+    void append_quoted(std::string &out, std::string_view text)
+    {
+        out += '"';
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                out += '\\';
+            if (c == '\n')
+                out += "\\n";
+            else
+                out += c;
+        }
+        out += '"';
+    }
+
+    uint64_t burst_key(const char *component, std::string_view message)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        for (const char *p = component; *p; ++p)
+            hash = (hash ^ static_cast<unsigned char>(*p)) * 1099511628211ULL;
+        for (char c : message)
+            hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+        return hash;
+    }
+}
+
+// registers the ring of a thread on first use and retires it when the thread ends
+struct RingHolder
+{
+    std::shared_ptr<Logger::Ring> ring;
+
+    RingHolder(Logger &logger) : ring(std::make_shared<Logger::Ring>())
+    {
+        ring->thread_id = next_thread_id++;
+        std::lock_guard<std::mutex> lock(logger._rings_mutex);
+        logger._rings.push_back(ring);
+    }
+
+    ~RingHolder()
+    {
+        ring->retired = true;
+    }
+};
+
+Logger::Logger() : _writer([this] { run(); })
+{
+}
+
+Logger::~Logger()
+{
+    _stop = true;
+    _wake.notify_one();
+    if (_writer.joinable())
+        _writer.join();
+}
+
+Logger &Logger::get()
+{
+    static Logger _instance;
+    return _instance;
+}
+
+Logger::Ring &Logger::ring()
+{
+    thread_local RingHolder holder(*this);
+    return *holder.ring;
+}
+
+void Logger::set_level(LogLevel level)
+{
+    _level = static_cast<int>(level);
+}
+
+bool Logger::enabled(LogLevel level) const
+{
+    return static_cast<int>(level) >= _level.load(std::memory_order_relaxed);
+}
+
+bool Logger::parse_level(const std::string &name, LogLevel &level)
+{
+    for (LogLevel l : {LogLevel::Debug, LogLevel::Info, LogLevel::Warning, LogLevel::Error})
+        if (name == level_name(l))
+        {
+            level = l;
+            return true;
+        }
+    return false;
+}
+
+uint64_t Logger::dropped() const
+{
+    return _dropped;
+}
+
+uint64_t Logger::suppressed() const
+{
+    return _suppressed;
+}
+
+void Logger::log(LogLevel level, const char *component, std::string_view message)
+{
+    if (!enabled(level))
+        return;
+    int64_t now = now_us();
+    Ring &r = ring();
+    if (level >= LogLevel::Warning && !admit(r, level, component, message, now))
+        return;
+
+    size_t tail = r.tail.load(std::memory_order_relaxed);
+    if (tail - r.head.load(std::memory_order_acquire) >= ring_capacity)
+    {
+        ++_dropped;
+        return;
+    }
+
+    Record &record = r.records[tail % ring_capacity];
+    record.timestamp_us = now;
+    record.level = level;
+    record.component = component;
+    record.length = static_cast<uint16_t>(std::min(message.size(), message_capacity));
+    std::memcpy(record.message, message.data(), record.length);
+    r.tail.store(tail + 1, std::memory_order_release);
+
+    if (level == LogLevel::Error)
+        _wake.notify_one();
+}
+
+// lets burst_limit identical warnings/errors of a thread through per window, counts the rest
+bool Logger::admit(Ring &r, LogLevel level, const char *component, std::string_view message, int64_t now)
+{
+    std::lock_guard<std::mutex> lock(r.burst_mutex);
+    Burst &burst = r.bursts[burst_key(component, message)];
+    if (now - burst.window_start_us >= burst_window_us)
+    {
+        // a count the writer has not reported yet carries over into the new window
+        burst.window_start_us = now;
+        burst.count = 0;
+        burst.level = level;
+        burst.component = component;
+    }
+    if (++burst.count <= burst_limit)
+        return true;
+    ++burst.suppressed;
+    ++_suppressed;
+    return false;
+}
+
+void Logger::flush_bursts(Ring &r, std::string &out, int64_t now, bool all)
+{
+    std::lock_guard<std::mutex> lock(r.burst_mutex);
+    for (auto it = r.bursts.begin(); it != r.bursts.end();)
+    {
+        Burst &burst = it->second;
+        bool window_over = now - burst.window_start_us >= burst_window_us;
+        if (burst.suppressed > 0 && (window_over || all))
+        {
+            append_time(out, now);
+            out += " level=";
+            out += level_name(burst.level);
+            out += " component=";
+            out += burst.component;
+            out += " msg=\"suppressed ";
+            out += std::to_string(burst.suppressed);
+            out += " repeated messages\"\n";
+            burst.suppressed = 0;
+        }
+        if (window_over && burst.suppressed == 0)
+            it = r.bursts.erase(it);
+        else
+            ++it;
+    }
+}
+
+bool Logger::drain(std::string &out, bool stopping)
+{
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+        std::lock_guard<std::mutex> lock(_rings_mutex);
+        rings = _rings;
+    }
+
+    bool wrote = false;
+    for (auto &r : rings)
+    {
+        // read retired before tail so a ring seen empty after retirement stays empty
+        bool retired = r->retired.load(std::memory_order_acquire);
+        size_t head = r->head.load(std::memory_order_relaxed);
+        size_t tail = r->tail.load(std::memory_order_acquire);
+        for (; head != tail; ++head)
+        {
+            const Record &record = r->records[head % ring_capacity];
+            append_time(out, record.timestamp_us);
+            out += " level=";
+            out += level_name(record.level);
+            out += " component=";
+            out += record.component;
+            out += " thread=";
+            out += std::to_string(r->thread_id);
+            out += " msg=";
+            append_quoted(out, std::string_view(record.message, record.length));
+            out += '\n';
+            wrote = true;
+        }
+        r->head.store(head, std::memory_order_release);
+        flush_bursts(*r, out, now_us(), stopping || retired);
+
+        if (retired)
+        {
+            std::lock_guard<std::mutex> lock(_rings_mutex);
+            _rings.erase(std::remove(_rings.begin(), _rings.end(), r), _rings.end());
+        }
+    }
+    return wrote;
+}
+
+void Logger::run()
+{
+    std::string out;
+    while (true)
+    {
+        bool stopping = _stop;
+        {
+            std::unique_lock<std::mutex> lock(_wake_mutex);
+            if (!stopping)
+                _wake.wait_for(lock, std::chrono::milliseconds(20));
+        }
+
+        out.clear();
+        drain(out, stopping);
+        uint64_t dropped = _dropped;
+        if (dropped != _reported_dropped)
+        {
+            append_time(out, now_us());
+            out += " level=warning component=logger msg=\"dropped ";
+            out += std::to_string(dropped - _reported_dropped);
+            out += " records, ring buffer full\"\n";
+            _reported_dropped = dropped;
+        }
+        if (!out.empty())
+            std::cout << out << std::flush;
+        if (stopping)
+            break;
+    }
+}
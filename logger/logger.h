@@ -0,0 +1,121 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+enum class LogLevel
+{
+    Debug,
+    Info,
+    Warning,
+    Error
+};
+
+// Asynchronous logger. Every thread appends fixed-size records to its own
+// lock-free ring buffer; a background thread drains the rings and writes
+// key=value lines to std::cout. A full ring drops the record and counts it,
+// and repeated warnings/errors are rate limited per thread, component and message.
+class Logger
+{
+public:
+    static Logger &get();
+
+    void log(LogLevel level, const char *component, std::string_view message);
+
+    void debug(const char *component, std::string_view message)
+    {
+        log(LogLevel::Debug, component, message);
+    }
+    void info(const char *component, std::string_view message)
+    {
+        log(LogLevel::Info, component, message);
+    }
+    void warning(const char *component, std::string_view message)
+    {
+        log(LogLevel::Warning, component, message);
+    }
+    void error(const char *component, std::string_view message)
+    {
+        log(LogLevel::Error, component, message);
+    }
+
+    void set_level(LogLevel level);
+    bool enabled(LogLevel level) const;
+    // debug, info, warning or error; false for anything else
+    static bool parse_level(const std::string &name, LogLevel &level);
+
+    uint64_t dropped() const;
+    uint64_t suppressed() const;
+
+    ~Logger();
+
+private:
+    static constexpr size_t ring_capacity = 1024;
+    static constexpr size_t message_capacity = 240;
+    static constexpr size_t burst_limit = 10;
+    static constexpr int64_t burst_window_us = 1000000;
+
+    struct Record
+    {
+        int64_t timestamp_us;
+        LogLevel level;
+        const char *component;
+        uint16_t length;
+        char message[message_capacity];
+    };
+
+    struct Burst
+    {
+        int64_t window_start_us = 0;
+        size_t count = 0;
+        size_t suppressed = 0;
+        LogLevel level = LogLevel::Warning;
+        std::string component;
+    };
+
+    // single producer (the owning thread), single consumer (the writer); the burst
+    // mutex is only shared with the writer, so threads never wait on each other
+    struct Ring
+    {
+        std::unique_ptr<Record[]> records{new Record[ring_capacity]};
+        std::atomic<size_t> head{0};
+        std::atomic<size_t> tail{0};
+        std::atomic<bool> retired{false};
+        uint64_t thread_id = 0;
+        std::mutex burst_mutex;
+        std::unordered_map<uint64_t, Burst> bursts;
+    };
+
+    friend struct RingHolder;
+
+    Logger();
+    Ring &ring();
+    bool admit(Ring &r, LogLevel level, const char *component, std::string_view message, int64_t now_us);
+    void run();
+    bool drain(std::string &out, bool stopping);
+    void flush_bursts(Ring &r, std::string &out, int64_t now_us, bool all);
+
+    std::atomic<int> _level{static_cast<int>(LogLevel::Info)};
+    std::atomic<uint64_t> _dropped{0};
+    std::atomic<uint64_t> _suppressed{0};
+    uint64_t _reported_dropped = 0;
+
+    std::mutex _rings_mutex;
+    std::vector<std::shared_ptr<Ring>> _rings;
+
+    std::mutex _wake_mutex;
+    std::condition_variable _wake;
+    std::atomic<bool> _stop{false};
+    std::thread _writer;
+};
+
+#endif
@@ -1,2 +1,4 @@
 sudo ./build/hl_mai_lab_01 --host=localhost --port=3306 --login=stud --password=stud --database=stud
 
+# bulk load authors (csv with header or ndjson), --init_db recreates the table first
+# ./build/hl_mai_lab_01_loader --host=localhost --login=stud --password=stud --database=stud --file=authors.csv --threads=8 --batch=1000 --drop_indexes
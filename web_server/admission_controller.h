@@ -0,0 +1,217 @@
+#ifndef ADMISSIONCONTROLLER_H
+#define ADMISSIONCONTROLLER_H
+
+#include "Poco/Clock.h"
+#include "Poco/JSON/Object.h"
+#include "Poco/Net/HTTPServer.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <string>
+
+// Operation classes in shedding order: Export and List are rejected first, Write last.
+// Export streams for as long as the client reads, so it only gets a fixed
+// concurrency cap and its latency stays out of the adaptive feedback. Email
+// lookups are mostly answered by the Bloom filter and have their own class so
+// they don't set the latency baseline of reads by id.
+enum class OperationClass
+{
+    Read,
+    Email,
+    Search,
+    Write,
+    List,
+    Export
+};
+
+// Adaptive concurrency limits per operation class. The limit of a class shrinks
+// while its latency runs above the observed baseline and grows back when the
+// latency recovers. Independently, the HTTPServer connection queue is turned
+// into an estimated queueing delay and cheaper classes tolerate more of it.
+class AdmissionController
+{
+public:
+    static constexpr size_t class_count = 6;
+
+    static AdmissionController &get()
+    {
+        static AdmissionController _instance;
+        return _instance;
+    }
+
+    void configure(const Poco::Net::HTTPServer *server, int max_threads, long max_queue_delay_ms)
+    {
+        _server = server;
+        _threads = std::max(1, max_threads);
+        _max_queue_delay_us = max_queue_delay_ms * 1000;
+        for (size_t i = 0; i < class_count; ++i)
+        {
+            State &state = _states[i];
+            std::lock_guard<std::mutex> lock(state.mutex);
+            state.max_limit = std::max(1.0, _threads * share[i]);
+            state.limit = state.max_limit;
+            state.published_limit = static_cast<long>(state.limit);
+        }
+    }
+
+    // false when the request has to be shed, retry_after is then set in seconds
+    bool try_acquire(OperationClass cls, long &retry_after)
+    {
+        State &state = _states[index(cls)];
+        long queue_delay = estimated_queue_delay_us();
+        retry_after = std::max(1L, (queue_delay + 999999) / 1000000);
+
+        if (queue_delay > static_cast<long>(_max_queue_delay_us * queue_tolerance[index(cls)]))
+        {
+            ++state.shed_queue;
+            return false;
+        }
+        if (++state.in_flight > state.published_limit)
+        {
+            --state.in_flight;
+            ++state.shed_limit;
+            return false;
+        }
+        ++state.admitted;
+        return true;
+    }
+
+    // sample is false for requests answered without the database, their latency
+    // says nothing about its load
+    void release(OperationClass cls, Poco::Clock::ClockDiff latency_us, bool sample)
+    {
+        State &state = _states[index(cls)];
+        --state.in_flight;
+        if (!adaptive[index(cls)] || !sample)
+            return;
+
+        double latency = static_cast<double>(std::max<Poco::Clock::ClockDiff>(1, latency_us));
+        double service = _service_us.load();
+        while (!_service_us.compare_exchange_weak(service, service * 0.95 + latency * 0.05))
+        {
+        }
+
+        std::unique_lock<std::mutex> lock(state.mutex, std::try_to_lock);
+        if (!lock.owns_lock())
+            return;
+        state.ewma_us = state.ewma_us > 0 ? state.ewma_us * 0.9 + latency * 0.1 : latency;
+        // the baseline is a long-window average of the short one: a few very fast
+        // requests can't pull it down, and it follows a lasting workload change
+        state.baseline_us = state.baseline_us > 0 ? state.baseline_us * 0.995 + state.ewma_us * 0.005 : latency;
+
+        double gradient = std::clamp(latency_tolerance * state.baseline_us / state.ewma_us, 0.5, 1.0);
+        double limit = state.limit * gradient + std::sqrt(state.limit);
+        state.limit = std::clamp(limit, 1.0, state.max_limit);
+        state.published_limit = static_cast<long>(state.limit);
+    }
+
+    Poco::JSON::Object::Ptr toJSON() const
+    {
+        Poco::JSON::Object::Ptr root = new Poco::JSON::Object();
+        root->set("queued_connections", _server ? _server->queuedConnections() : 0);
+        root->set("estimated_queue_delay_ms", estimated_queue_delay_us() / 1000.0);
+        for (size_t i = 0; i < class_count; ++i)
+        {
+            const State &state = _states[i];
+            Poco::JSON::Object::Ptr item = new Poco::JSON::Object();
+            item->set("in_flight", state.in_flight.load());
+            item->set("limit", state.published_limit.load());
+            item->set("admitted", state.admitted.load());
+            item->set("shed_limit", state.shed_limit.load());
+            item->set("shed_queue", state.shed_queue.load());
+            root->set(names[i], item);
+        }
+        return root;
+    }
+
+private:
+    struct State
+    {
+        std::mutex mutex;
+        double limit = 1;
+        double max_limit = 1;
+        double ewma_us = 0;
+        double baseline_us = 0;
+        std::atomic<long> published_limit{1};
+        std::atomic<long> in_flight{0};
+        std::atomic<long> admitted{0};
+        std::atomic<long> shed_limit{0};
+        std::atomic<long> shed_queue{0};
+    };
+
+    // share of worker threads a class may occupy, the part of the queue delay
+    // budget it accepts and whether its latency adapts the limit, indexed by OperationClass
+    static constexpr double share[class_count] = {1.0, 1.0, 0.75, 1.0, 0.25, 0.25};
+    static constexpr double queue_tolerance[class_count] = {1.0, 1.0, 0.5, 1.0, 0.25, 0.25};
+    static constexpr bool adaptive[class_count] = {true, true, true, true, true, false};
+    static constexpr const char *names[class_count] = {"read", "email", "search", "write", "list", "export"};
+    static constexpr double latency_tolerance = 2.0;
+
+    AdmissionController()
+    {
+    }
+
+    static size_t index(OperationClass cls)
+    {
+        return static_cast<size_t>(cls);
+    }
+
+    long estimated_queue_delay_us() const
+    {
+        if (!_server)
+            return 0;
+        return static_cast<long>(_server->queuedConnections() * _service_us.load() / _threads);
+    }
+
+    const Poco::Net::HTTPServer *_server = nullptr;
+    int _threads = 1;
+    long _max_queue_delay_us = 200000;
+    std::atomic<double> _service_us{1000};
+    std::array<State, class_count> _states;
+};
+
+// Holds an admitted slot and reports the request latency when it goes out of scope.
+class AdmissionTicket
+{
+public:
+    AdmissionTicket(OperationClass cls) : _cls(cls)
+    {
+        _admitted = AdmissionController::get().try_acquire(cls, _retry_after);
+    }
+
+    ~AdmissionTicket()
+    {
+        if (_admitted)
+            AdmissionController::get().release(_cls, _started.elapsed(), _sample);
+    }
+
+    AdmissionTicket(const AdmissionTicket &) = delete;
+    AdmissionTicket &operator=(const AdmissionTicket &) = delete;
+
+    bool admitted() const
+    {
+        return _admitted;
+    }
+
+    long retry_after() const
+    {
+        return _retry_after;
+    }
+
+    // the request was answered from memory, keep its latency out of the feedback
+    void skip_sample()
+    {
+        _sample = false;
+    }
+
+private:
+    OperationClass _cls;
+    Poco::Clock _started;
+    bool _admitted = false;
+    bool _sample = true;
+    long _retry_after = 1;
+};
+
+#endif // !ADMISSIONCONTROLLER_H
@@ -0,0 +1,57 @@
+#ifndef CONNECTIONSTATS_H
+#define CONNECTIONSTATS_H
+
+#include "Poco/JSON/Object.h"
+#include "Poco/Net/HTTPServer.h"
+#include "Poco/Net/HTTPServerRequest.h"
+#include <atomic>
+
+// Counts requests; connections come from the server's own counters, so reuse
+// rate and requests per connection are exact.
+class ConnectionStats
+{
+public:
+    static ConnectionStats &get()
+    {
+        static ConnectionStats _instance;
+        return _instance;
+    }
+
+    void configure(const Poco::Net::HTTPServer *server)
+    {
+        _server = server;
+    }
+
+    void on_request(const Poco::Net::HTTPServerRequest &request)
+    {
+        ++_requests;
+        if (!request.getKeepAlive())
+            ++_closing_requests;
+    }
+
+    Poco::JSON::Object::Ptr toJSON() const
+    {
+        long requests = _requests;
+        long connections = _server ? _server->totalConnections() : 0;
+        Poco::JSON::Object::Ptr root = new Poco::JSON::Object();
+        root->set("requests", requests);
+        root->set("connections", connections);
+        root->set("current_connections", _server ? _server->currentConnections() : 0);
+        root->set("reused_requests", requests > connections ? requests - connections : 0);
+        root->set("closing_requests", _closing_requests.load());
+        root->set("reuse_rate", requests > connections ? static_cast<double>(requests - connections) / requests : 0.0);
+        root->set("requests_per_connection", connections ? static_cast<double>(requests) / connections : 0.0);
+        return root;
+    }
+
+private:
+    ConnectionStats()
+    {
+    }
+
+    const Poco::Net::HTTPServer *_server = nullptr;
+    std::atomic<long> _requests{0};
+    std::atomic<long> _closing_requests{0};
+};
+
+#endif // !CONNECTIONSTATS_H
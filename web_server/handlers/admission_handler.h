@@ -0,0 +1,28 @@
+#ifndef ADMISSIONHANDLER_H
+#define ADMISSIONHANDLER_H
+
+#include "Poco/Net/HTTPRequestHandler.h"
+#include "Poco/Net/HTTPServerRequest.h"
+#include "Poco/Net/HTTPServerResponse.h"
+
+using Poco::Net::HTTPRequestHandler;
+using Poco::Net::HTTPServerRequest;
+using Poco::Net::HTTPServerResponse;
+
+#include "../admission_controller.h"
+#include "json_reply.h"
+#include "pooled_handler.h"
+
+// concurrency limits, in-flight requests and shed counters per operation class
+class AdmissionHandler : public HTTPRequestHandler, public PooledHandler<AdmissionHandler>
+{
+public:
+    void handleRequest(HTTPServerRequest &request,
+                       HTTPServerResponse &response)
+    {
+        JsonReply::skip_body(request, response);
+        JsonReply::send(response, AdmissionController::get().toJSON());
+    }
+
+};
+#endif // !ADMISSIONHANDLER_H
@@ -8,7 +8,6 @@
 #include "Poco/Net/HTTPServerRequest.h"
 #include "Poco/Net/HTTPServerResponse.h"
 #include "Poco/Net/HTTPServerParams.h"
-#include "Poco/Net/HTMLForm.h"
 #include "Poco/Net/ServerSocket.h"
 #include "Poco/Timestamp.h"
 #include "Poco/DateTimeFormatter.h"
@@ -19,15 +18,18 @@
 #include "Poco/Util/Option.h"
 #include "Poco/Util/OptionSet.h"
 #include "Poco/Util/HelpFormatter.h"
+#include "Poco/JSON/Array.h"
+#include "Poco/JSON/Stringifier.h"
 #include <iostream>
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <charconv>
 
 using Poco::DateTimeFormat;
 using Poco::DateTimeFormatter;
 using Poco::ThreadPool;
 using Poco::Timestamp;
-using Poco::Net::HTMLForm;
 using Poco::Net::HTTPRequestHandler;
 using Poco::Net::HTTPRequestHandlerFactory;
 using Poco::Net::HTTPServer;
@@ -44,171 +46,246 @@ using Poco::Util::OptionSet;
 using Poco::Util::ServerApplication;
 
 #include "../../database/author.h"
+#include "../../database/email_filter.h"
+#include "../../database/deadline.h"
+#include "../../config/config.h"
+#include "json_reply.h"
+#include "../admission_controller.h"
+#include "pooled_handler.h"
 
-class AuthorHandler : public HTTPRequestHandler
+class AuthorHandler : public HTTPRequestHandler, public PooledHandler<AuthorHandler>
 {
 private:
-    bool check_name(const std::string &name, std::string &reason)
+    static void stream_json(HTTPServerResponse &response, const Poco::Dynamic::Var &value)
     {
-        if (name.length() < 3)
+        response.setChunkedTransferEncoding(true);
+        response.setContentType("application/json");
+        Poco::JSON::Stringifier::stringify(value, response.send());
+    }
+
+    // reports a failed database call, as 504 when the request ran out of time
+    static void send_failure(HTTPServerResponse &response, const std::string &body)
+    {
+        if (database::Deadline::expired())
+            JsonReply::send(response, "{ \"result\": false , \"reason\": \"deadline exceeded\" }", Poco::Net::HTTPResponse::HTTP_GATEWAY_TIMEOUT);
+        else
+            JsonReply::send(response, body);
+    }
+
+    // X-Request-Timeout-Ms may lower or raise the configured timeout up to the configured maximum
+    static long request_timeout(const HTTPServerRequest &request)
+    {
+        long timeout = Config::get().get_request_timeout();
+        std::string header = request.get("X-Request-Timeout-Ms", "");
+        long requested = 0;
+        auto parsed = std::from_chars(header.data(), header.data() + header.size(), requested);
+        if (!header.empty() && parsed.ec == std::errc() && parsed.ptr == header.data() + header.size() && requested > 0)
+            timeout = std::min(requested, Config::get().get_max_request_timeout());
+        return timeout;
+    }
+
+    static OperationClass operation_class(RequestParams::Operation operation)
+    {
+        switch (operation)
         {
-            reason = "Name must be at leas 3 signs";
-            return false;
+        case RequestParams::Operation::ById:
+            return OperationClass::Read;
+        case RequestParams::Operation::Email:
+            return OperationClass::Email;
+        case RequestParams::Operation::Search:
+            return OperationClass::Search;
+        case RequestParams::Operation::Add:
+            return OperationClass::Write;
+        case RequestParams::Operation::List:
+            break;
         }
+        return OperationClass::List;
+    }
 
-        if (name.find(' ') != std::string::npos)
+    void read_by_id(const RequestParams &params, HTTPServerResponse &response)
+    {
+        long id = 0;
+        if (!params.get_long("id", id))
         {
-            reason = "Name can't contain spaces";
-            return false;
+            JsonReply::send(response, "{ \"result\": false , \"reason\": \"invalid id\" }", Poco::Net::HTTPResponse::HTTP_BAD_REQUEST);
+            return;
         }
-
-        if (name.find('\t') != std::string::npos)
+        try
         {
-            reason = "Name can't contain spaces";
-            return false;
+            database::Author result = database::Author::read_by_id(id);
+            stream_json(response, result.toJSON());
         }
+        catch (...)
+        {
+            send_failure(response, "{ \"result\": false , \"reason\": \"not found\" }");
+        }
+    }
 
-        return true;
-    };
+    void search(const RequestParams &params, HTTPServerResponse &response)
+    {
+        if (!params.has("first_name") || !params.has("last_name"))
+        {
+            JsonReply::send(response, "{ \"result\": false , \"reason\": \"not gound\" }");
+            return;
+        }
+        try
+        {
+            auto results = database::Author::search(std::string(params.get("first_name")),
+                                                    std::string(params.get("last_name")),
+                                                    params.has("exact"));
+            Poco::JSON::Array::Ptr arr = new Poco::JSON::Array();
+            for (auto &s : results)
+                arr->add(s.toJSON());
+            stream_json(response, arr);
+        }
+        catch (...)
+        {
+            send_failure(response, "{ \"result\": false , \"reason\": \"not gound\" }");
+        }
+    }
 
-    bool check_email(const std::string &email, std::string &reason)
+    void add(const RequestParams &params, HTTPServerResponse &response)
     {
-        if (email.find('@') == std::string::npos)
+        database::Author author;
+        author.first_name() = params.get("first_name");
+        author.last_name() = params.get("last_name");
+        author.email() = params.get("email");
+        author.title() = params.get("title");
+
+        bool check_result = true;
+        std::string message;
+        std::string reason;
+
+        if (!database::Author::check_name(author.get_first_name(), reason))
         {
-            reason = "Email must contain @";
-            return false;
+            check_result = false;
+            message += reason;
+            message += "<br>";
         }
 
-        if (email.find(' ') != std::string::npos)
+        if (!database::Author::check_name(author.get_last_name(), reason))
         {
-            reason = "EMail can't contain spaces";
-            return false;
+            check_result = false;
+            message += reason;
+            message += "<br>";
         }
 
-        if (email.find('\t') != std::string::npos)
+        if (!database::Author::check_email(author.get_email(), reason))
         {
-            reason = "EMail can't contain spaces";
-            return false;
+            check_result = false;
+            message += reason;
+            message += "<br>";
         }
 
-        return true;
-    };
+        if (!check_result)
+        {
+            JsonReply::send(response, "{ \"result\": false , \"reason\": \"" + message + "\" }");
+            return;
+        }
 
-public:
-    AuthorHandler(const std::string &format) : _format(format)
+        try
+        {
+            author.save_to_mysql();
+            JsonReply::send(response, "{ \"result\": true }");
+        }
+        catch (...)
+        {
+            send_failure(response, "{ \"result\": false , \"reason\": \" database error\" }");
+        }
+    }
+
+    void find_email(const RequestParams &params, HTTPServerResponse &response, AdmissionTicket &ticket)
     {
+        std::string email(params.get("email"));
+        database::EmailFilter &filter = database::EmailFilter::get();
+        if (!filter.might_contain(email))
+        {
+            ticket.skip_sample();
+            JsonReply::send(response, "{ \"result\": false , \"reason\": \"not found\" }");
+            return;
+        }
+        try
+        {
+            database::Author result = database::Author::read_by_email(email);
+            JsonReply::send(response, "{ \"result\": true , \"id\": " + std::to_string(result.get_id()) + " }");
+        }
+        catch (std::logic_error &)
+        {
+            if (filter.ready())
+                filter.report_false_positive();
+            JsonReply::send(response, "{ \"result\": false , \"reason\": \"not found\" }");
+        }
+        catch (...)
+        {
+            send_failure(response, "{ \"result\": false , \"reason\": \" database error\" }");
+        }
+    }
+
+    void list(HTTPServerResponse &response)
+    {
+        std::vector<database::Author> results;
+        try
+        {
+            results = database::Author::read_all();
+        }
+        catch (...)
+        {
+            send_failure(response, "{ \"result\": false , \"reason\": \" database error\" }");
+            return;
+        }
+        Poco::JSON::Array::Ptr arr = new Poco::JSON::Array();
+        for (auto &s : results)
+            arr->add(s.toJSON());
+        stream_json(response, arr);
     }
 
+public:
     void handleRequest(HTTPServerRequest &request,
                        HTTPServerResponse &response)
     {
-        HTMLForm form(request, request.stream());
-        response.setChunkedTransferEncoding(true);
-        response.setContentType("application/json");
-        std::ostream &ostr = response.send();
-
-        if (form.has("id"))
+        RequestParams params;
+        bool parsed = params.parse(request);
+        JsonReply::close_if_unread(params, response);
+        if (!parsed)
         {
-            long id = atol(form.get("id").c_str());
-            try
+            if (params.unsupported_body())
             {
-                database::Author result = database::Author::read_by_id(id);
-                Poco::JSON::Stringifier::stringify(result.toJSON(), ostr);
-                return;
-            }
-            catch (...)
-            {
-                ostr << "{ \"result\": false , \"reason\": \"not found\" }";
+                JsonReply::send(response, "{ \"result\": false , \"reason\": \"body must be application/x-www-form-urlencoded\" }",
+                                Poco::Net::HTTPResponse::HTTP_UNSUPPORTEDMEDIATYPE);
                 return;
             }
+            JsonReply::send(response, "{ \"result\": false , \"reason\": \"malformed request\" }", Poco::Net::HTTPResponse::HTTP_BAD_REQUEST);
+            return;
         }
-        else if (form.has("search"))
+
+        AdmissionTicket ticket(operation_class(params.operation()));
+        if (!ticket.admitted())
         {
-            try
-            {
-                std::string  fn = form.get("first_name");
-                std::string  ln = form.get("last_name");
-                auto results = database::Author::search(fn,ln);
-                Poco::JSON::Array arr;
-                for (auto s : results)
-                    arr.add(s.toJSON());
-                Poco::JSON::Stringifier::stringify(arr, ostr);
-            }
-            catch (...)
-            {
-                ostr << "{ \"result\": false , \"reason\": \"not gound\" }";
-                return;
-            }
+            response.set("Retry-After", std::to_string(ticket.retry_after()));
+            JsonReply::send(response, "{ \"result\": false , \"reason\": \"overloaded\" }", Poco::Net::HTTPResponse::HTTP_SERVICE_UNAVAILABLE);
             return;
         }
-        else if (form.has("add"))
-        {
-            if (form.has("first_name"))
-                if (form.has("last_name"))
-                    if (form.has("email"))
-                        if (form.has("title"))
-                        {
-                            database::Author author;
-                            author.first_name() = form.get("first_name");
-                            author.last_name() = form.get("last_name");
-                            author.email() = form.get("email");
-                            author.title() = form.get("title");
-
-                            bool check_result = true;
-                            std::string message;
-                            std::string reason;
-
-                            if (!check_name(author.get_first_name(), reason))
-                            {
-                                check_result = false;
-                                message += reason;
-                                message += "<br>";
-                            }
-
-                            if (!check_name(author.get_last_name(), reason))
-                            {
-                                check_result = false;
-                                message += reason;
-                                message += "<br>";
-                            }
-
-                            if (!check_email(author.get_email(), reason))
-                            {
-                                check_result = false;
-                                message += reason;
-                                message += "<br>";
-                            }
-
-                            if (check_result)
-                            {
-                                try
-                                {
-                                    author.save_to_mysql();
-                                    ostr << "{ \"result\": true }";
-                                    return;
-                                }
-                                catch (...)
-                                {
-                                    ostr << "{ \"result\": false , \"reason\": \" database error\" }";
-                                    return;
-                                }
-                            }
-                            else
-                            {
-                                ostr << "{ \"result\": false , \"reason\": \"" << message << "\" }";
-                                return;
-                            }
-                        }
-        }
-
-        auto results = database::Author::read_all();
-        Poco::JSON::Array arr;
-        for (auto s : results)
-            arr.add(s.toJSON());
-        Poco::JSON::Stringifier::stringify(arr, ostr);
+
+        database::DeadlineScope deadline(request_timeout(request));
+        switch (params.operation())
+        {
+        case RequestParams::Operation::ById:
+            read_by_id(params, response);
+            break;
+        case RequestParams::Operation::Search:
+            search(params, response);
+            break;
+        case RequestParams::Operation::Add:
+            add(params, response);
+            break;
+        case RequestParams::Operation::Email:
+            find_email(params, response, ticket);
+            break;
+        case RequestParams::Operation::List:
+            list(response);
+            break;
+        }
     }
 
-private:
-    std::string _format;
 };
 #endif // !AUTHORHANDLER_H
\ No newline at end of file
@@ -0,0 +1,27 @@
+#ifndef CONNECTIONSHANDLER_H
+#define CONNECTIONSHANDLER_H
+
+#include "Poco/Net/HTTPRequestHandler.h"
+#include "Poco/Net/HTTPServerRequest.h"
+#include "Poco/Net/HTTPServerResponse.h"
+
+using Poco::Net::HTTPRequestHandler;
+using Poco::Net::HTTPServerRequest;
+using Poco::Net::HTTPServerResponse;
+
+#include "../connection_stats.h"
+#include "json_reply.h"
+#include "pooled_handler.h"
+
+// connection reuse rate and requests per connection
+class ConnectionsHandler : public HTTPRequestHandler, public PooledHandler<ConnectionsHandler>
+{
+public:
+    void handleRequest(HTTPServerRequest &request,
+                       HTTPServerResponse &response)
+    {
+        JsonReply::skip_body(request, response);
+        JsonReply::send(response, ConnectionStats::get().toJSON());
+    }
+};
+#endif // !CONNECTIONSHANDLER_H
@@ -0,0 +1,42 @@
+#ifndef EMAILFILTERHANDLER_H
+#define EMAILFILTERHANDLER_H
+
+#include "Poco/Net/HTTPRequestHandler.h"
+#include "Poco/Net/HTTPServerRequest.h"
+#include "Poco/Net/HTTPServerResponse.h"
+#include "Poco/JSON/Object.h"
+
+using Poco::Net::HTTPRequestHandler;
+using Poco::Net::HTTPServerRequest;
+using Poco::Net::HTTPServerResponse;
+
+#include "../../database/email_filter.h"
+#include "json_reply.h"
+#include "pooled_handler.h"
+
+// counters of the email Bloom filter: how many lookups were answered without MySQL
+class EmailFilterHandler : public HTTPRequestHandler, public PooledHandler<EmailFilterHandler>
+{
+public:
+    void handleRequest(HTTPServerRequest &request,
+                       HTTPServerResponse &response)
+    {
+        JsonReply::skip_body(request, response);
+        database::EmailFilter &filter = database::EmailFilter::get();
+        Poco::JSON::Object::Ptr root = new Poco::JSON::Object();
+        root->set("ready", filter.ready());
+        root->set("entries", filter.inserted());
+        root->set("bits", filter.bit_count());
+        root->set("hashes", filter.hash_count());
+        root->set("lookups", filter.lookups());
+        root->set("short_circuits", filter.short_circuits());
+        root->set("bypassed", filter.bypassed());
+        root->set("false_positives", filter.false_positives());
+        root->set("observed_fp_rate", filter.observed_fp_rate());
+        root->set("estimated_fp_rate", filter.estimated_fp_rate());
+
+        JsonReply::send(response, root);
+    }
+
+};
+#endif // !EMAILFILTERHANDLER_H
@@ -0,0 +1,343 @@
+#ifndef EXPORTHANDLER_H
+#define EXPORTHANDLER_H
+
+#include "Poco/Net/HTTPRequestHandler.h"
+#include "Poco/Net/HTTPServerRequest.h"
+#include "Poco/Net/HTTPServerResponse.h"
+#include "Poco/Net/HTTPServerRequestImpl.h"
+#include "Poco/Net/HTTPServerSession.h"
+#include "Poco/Exception.h"
+#include "Poco/JSON/Stringifier.h"
+#include "Poco/Timestamp.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+using Poco::Timestamp;
+using Poco::Net::HTTPRequestHandler;
+using Poco::Net::HTTPServerRequest;
+using Poco::Net::HTTPServerResponse;
+
+#include "../../database/author.h"
+#include "../../logger/logger.h"
+#include "json_reply.h"
+#include "../admission_controller.h"
+#include "pooled_handler.h"
+
+// Bounded hand-off between partition scanners and the socket writer.
+// A full queue blocks its producers, so a slow client throttles the scans.
+class ExportChunkQueue
+{
+public:
+    ExportChunkQueue(size_t capacity, size_t producers) : _capacity(capacity), _producers(producers)
+    {
+    }
+
+    bool push(std::string &&chunk)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _not_full.wait(lock, [this] { return _cancelled || _chunks.size() < _capacity; });
+        if (_cancelled)
+            return false;
+        _chunks.push_back(std::move(chunk));
+        _not_empty.notify_one();
+        return true;
+    }
+
+    // false once every producer has finished and the queue is drained
+    bool pop(std::string &chunk)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _not_empty.wait(lock, [this] { return _cancelled || !_chunks.empty() || _producers == 0; });
+        if (_cancelled || _chunks.empty())
+            return false;
+        chunk = std::move(_chunks.front());
+        _chunks.pop_front();
+        _not_full.notify_one();
+        return true;
+    }
+
+    void producer_done()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_producers > 0)
+            --_producers;
+        _not_empty.notify_all();
+    }
+
+    void cancel()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _cancelled = true;
+        _not_full.notify_all();
+        _not_empty.notify_all();
+    }
+
+private:
+    std::mutex _mutex;
+    std::condition_variable _not_full;
+    std::condition_variable _not_empty;
+    std::deque<std::string> _chunks;
+    size_t _capacity;
+    size_t _producers;
+    bool _cancelled = false;
+};
+
+class ExportHandler : public HTTPRequestHandler, public PooledHandler<ExportHandler>
+{
+private:
+    // cancels the queues and joins every started scanner, also when starting one throws
+    class ScannerGuard
+    {
+    public:
+        ScannerGuard(std::vector<std::unique_ptr<ExportChunkQueue>> &queues, std::vector<std::thread> &scanners)
+            : _queues(queues), _scanners(scanners)
+        {
+        }
+
+        ~ScannerGuard()
+        {
+            for (auto &queue : _queues)
+                queue->cancel();
+            for (auto &scanner : _scanners)
+                if (scanner.joinable())
+                    scanner.join();
+        }
+
+    private:
+        std::vector<std::unique_ptr<ExportChunkQueue>> &_queues;
+        std::vector<std::thread> &_scanners;
+    };
+
+    static constexpr size_t default_partitions = 4;
+    static constexpr size_t max_partitions = 32;
+    static constexpr size_t default_batch = 1000;
+    static constexpr size_t max_batch = 10000;
+    static constexpr size_t chunks_per_partition = 4;
+
+    static void write_csv_field(std::ostream &out, const std::string &value)
+    {
+        if (value.find_first_of(",\"\r\n") == std::string::npos)
+        {
+            out << value;
+            return;
+        }
+        out << '"';
+        for (char c : value)
+        {
+            if (c == '"')
+                out << '"';
+            out << c;
+        }
+        out << '"';
+    }
+
+    static std::string serialize(const std::vector<database::Author> &rows, bool csv)
+    {
+        std::ostringstream out;
+        for (const auto &a : rows)
+        {
+            if (csv)
+            {
+                out << a.get_id() << ',';
+                write_csv_field(out, a.get_first_name());
+                out << ',';
+                write_csv_field(out, a.get_last_name());
+                out << ',';
+                write_csv_field(out, a.get_email());
+                out << ',';
+                write_csv_field(out, a.get_title());
+                out << '\n';
+            }
+            else
+            {
+                Poco::JSON::Stringifier::stringify(a.toJSON(), out);
+                out << '\n';
+            }
+        }
+        return out.str();
+    }
+
+    // The status line is already out, so a failure can only be reported by not
+    // finishing the chunked body: shut the socket down before Poco writes the
+    // terminating chunk and let the server drop the connection.
+    [[noreturn]] static void abort_response(HTTPServerRequest &request, std::ostream &ostr)
+    {
+        ostr.flush();
+        try
+        {
+            if (auto *impl = dynamic_cast<Poco::Net::HTTPServerRequestImpl *>(&request))
+                impl->session().socket().shutdown();
+        }
+        catch (Poco::Exception &)
+        {
+        }
+        throw Poco::IOException("export aborted");
+    }
+
+    static size_t parse_size(const RequestParams &params, std::string_view name, size_t def, size_t max)
+    {
+        long value = 0;
+        if (!params.get_long(name, value) || value <= 0)
+            return def;
+        return std::min(static_cast<size_t>(value), max);
+    }
+
+public:
+    void handleRequest(HTTPServerRequest &request,
+                       HTTPServerResponse &response)
+    {
+        RequestParams params;
+        bool parsed = params.parse(request);
+        JsonReply::close_if_unread(params, response);
+        std::string format(params.get("format", "ndjson"));
+        bool csv = (format == "csv");
+        if (!parsed && params.unsupported_body())
+        {
+            JsonReply::send(response, "{ \"result\": false , \"reason\": \"body must be application/x-www-form-urlencoded\" }",
+                            Poco::Net::HTTPResponse::HTTP_UNSUPPORTEDMEDIATYPE);
+            return;
+        }
+        if (!parsed || (!csv && format != "ndjson"))
+        {
+            JsonReply::send(response, parsed ? "{ \"result\": false , \"reason\": \"format must be ndjson or csv\" }"
+                                             : "{ \"result\": false , \"reason\": \"malformed request\" }",
+                            Poco::Net::HTTPResponse::HTTP_BAD_REQUEST);
+            return;
+        }
+        AdmissionTicket ticket(OperationClass::Export);
+        if (!ticket.admitted())
+        {
+            response.set("Retry-After", std::to_string(ticket.retry_after()));
+            JsonReply::send(response, "{ \"result\": false , \"reason\": \"overloaded\" }",
+                            Poco::Net::HTTPResponse::HTTP_SERVICE_UNAVAILABLE);
+            return;
+        }
+        bool ordered = params.get("ordered", "true") != "false";
+        size_t partitions = parse_size(params, "partitions", default_partitions, max_partitions);
+        size_t batch = parse_size(params, "batch", default_batch, max_batch);
+
+        long min_id = 0, max_id = 0;
+        try
+        {
+            database::Author::id_bounds(min_id, max_id);
+        }
+        catch (...)
+        {
+            JsonReply::send(response, "{ \"result\": false , \"reason\": \" database error\" }",
+                            Poco::Net::HTTPResponse::HTTP_INTERNAL_SERVER_ERROR);
+            return;
+        }
+
+        response.setChunkedTransferEncoding(true);
+        response.setContentType(csv ? "text/csv" : "application/x-ndjson");
+        std::ostream &ostr = response.send();
+        Timestamp started;
+        size_t bytes = 0;
+
+        if (csv)
+        {
+            static const std::string header = "id,first_name,last_name,email,title\n";
+            ostr << header;
+            bytes += header.size();
+        }
+
+        if (max_id >= min_id && max_id > 0)
+        {
+            // split (min_id-1, max_id] into contiguous id partitions of equal width
+            long span = max_id - min_id + 1;
+            partitions = std::min(partitions, static_cast<size_t>(span));
+            long width = (span + static_cast<long>(partitions) - 1) / static_cast<long>(partitions);
+
+            // ordered output drains partitions one after another, unordered output shares one queue
+            std::vector<std::unique_ptr<ExportChunkQueue>> queues;
+            if (ordered)
+                for (size_t i = 0; i < partitions; ++i)
+                    queues.emplace_back(new ExportChunkQueue(chunks_per_partition, 1));
+            else
+                queues.emplace_back(new ExportChunkQueue(chunks_per_partition * partitions, partitions));
+
+            std::atomic<bool> failed{false};
+            std::vector<std::thread> scanners;
+            ScannerGuard guard(queues, scanners);
+            try
+            {
+                for (size_t i = 0; i < partitions; ++i)
+                {
+                    long from_id = min_id - 1 + static_cast<long>(i) * width;
+                    long to_id = std::min(from_id + width, max_id);
+                    ExportChunkQueue &queue = *queues[ordered ? i : 0];
+                    scanners.emplace_back([&queue, &failed, from_id, to_id, batch, csv]() {
+                        try
+                        {
+                            database::Author::scan_range(from_id, to_id, batch,
+                                                         [&queue, csv](std::vector<database::Author> &rows) {
+                                                             return queue.push(serialize(rows, csv));
+                                                         });
+                        }
+                        catch (std::exception &e)
+                        {
+                            Logger::get().error("export", "partition (" + std::to_string(from_id) + "," + std::to_string(to_id) + "]:" + e.what());
+                            failed = true;
+                        }
+                        queue.producer_done();
+                    });
+                }
+            }
+            catch (std::system_error &e)
+            {
+                Logger::get().error("export", std::string("can't start scanner:") + e.what());
+                failed = true;
+            }
+
+            std::string chunk;
+            for (auto &queue : queues)
+            {
+                while (!failed && queue->pop(chunk))
+                {
+                    ostr.write(chunk.data(), chunk.size());
+                    bytes += chunk.size();
+                    if (!ostr.good())
+                    {
+                        failed = true;
+                        break;
+                    }
+                }
+                if (failed)
+                    break;
+            }
+
+            if (failed)
+                for (auto &queue : queues)
+                    queue->cancel();
+            for (auto &scanner : scanners)
+                scanner.join();
+            if (failed)
+            {
+                Logger::get().warning("export", "aborted after " + std::to_string(bytes) + " bytes");
+                abort_response(request, ostr);
+            }
+        }
+
+        double seconds = static_cast<double>(started.elapsed()) / 1000000.0;
+        double mb = static_cast<double>(bytes) / (1024.0 * 1024.0);
+        std::ostringstream summary;
+        summary << "format=" << format
+                << " partitions=" << partitions
+                << " ordered=" << (ordered ? "true" : "false")
+                << " bytes=" << bytes
+                << " seconds=" << seconds
+                << " MB/s=" << (seconds > 0 ? mb / seconds : 0.0);
+        Logger::get().info("export", summary.str());
+    }
+
+};
+#endif // !EXPORTHANDLER_H
@@ -0,0 +1,50 @@
+#ifndef JSONREPLY_H
+#define JSONREPLY_H
+
+#include "Poco/Net/HTTPResponse.h"
+#include "Poco/Net/HTTPServerRequest.h"
+#include "Poco/Net/HTTPServerResponse.h"
+#include "Poco/JSON/Object.h"
+#include "Poco/JSON/Stringifier.h"
+#include <sstream>
+#include <string>
+
+#include "request_params.h"
+
+// Replies shared by the handlers that keep persistent connections usable:
+// every reply carries its length, Poco closes the connection after one without,
+// and a request body left unread closes it, it would be taken for the next request.
+class JsonReply
+{
+public:
+    static void send(HTTPServerResponse &response, const std::string &body,
+                     Poco::Net::HTTPResponse::HTTPStatus status = Poco::Net::HTTPResponse::HTTP_OK)
+    {
+        response.setStatus(status);
+        response.setContentType("application/json");
+        response.setContentLength(body.size());
+        response.send() << body;
+    }
+
+    static void send(HTTPServerResponse &response, const Poco::JSON::Object::Ptr &value)
+    {
+        std::ostringstream body;
+        Poco::JSON::Stringifier::stringify(value, body);
+        send(response, body.str());
+    }
+
+    static void close_if_unread(const RequestParams &params, HTTPServerResponse &response)
+    {
+        if (params.body_unread())
+            response.setKeepAlive(false);
+    }
+
+    // for handlers without parameters
+    static void skip_body(HTTPServerRequest &request, HTTPServerResponse &response)
+    {
+        if (!RequestParams::skip_body(request))
+            response.setKeepAlive(false);
+    }
+};
+
+#endif // !JSONREPLY_H
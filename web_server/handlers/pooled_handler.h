@@ -0,0 +1,62 @@
+#ifndef POOLEDHANDLER_H
+#define POOLEDHANDLER_H
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// HTTPServerConnection creates and deletes the request handler on the connection
+// thread, so handlers deriving from PooledHandler<T> recycle their storage through
+// a small per-thread free list instead of the global heap.
+template <typename T>
+class PooledHandler
+{
+public:
+    static void *operator new(std::size_t size)
+    {
+        std::vector<void *> &pool = free_list();
+        if (size == sizeof(T) && !pool.empty())
+        {
+            void *p = pool.back();
+            pool.pop_back();
+            return p;
+        }
+        return ::operator new(size);
+    }
+
+    static void operator delete(void *p, std::size_t size)
+    {
+        std::vector<void *> &pool = free_list();
+        if (size == sizeof(T) && pool.size() < pool_capacity)
+            pool.push_back(p);
+        else
+            ::operator delete(p);
+    }
+
+private:
+    static constexpr std::size_t pool_capacity = 4;
+
+    struct FreeList
+    {
+        std::vector<void *> blocks;
+
+        FreeList()
+        {
+            blocks.reserve(pool_capacity);
+        }
+
+        ~FreeList()
+        {
+            for (void *p : blocks)
+                ::operator delete(p);
+        }
+    };
+
+    static std::vector<void *> &free_list()
+    {
+        thread_local FreeList list;
+        return list.blocks;
+    }
+};
+
+#endif // !POOLEDHANDLER_H
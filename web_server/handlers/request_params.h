@@ -0,0 +1,274 @@
+#ifndef REQUESTPARAMS_H
+#define REQUESTPARAMS_H
+
+#include "Poco/Net/HTTPRequest.h"
+#include "Poco/Net/HTTPServerRequest.h"
+#include <array>
+#include <charconv>
+#include <istream>
+#include <string>
+#include <string_view>
+
+using Poco::Net::HTTPServerRequest;
+
+// Query string and url-encoded body parser for /author requests.
+// The raw query and body are copied once into a per-request buffer and
+// percent-decoded in place; names and values are string_views into it.
+// The operation is classified during the same pass.
+class RequestParams
+{
+public:
+    enum class Operation
+    {
+        List,
+        ById,
+        Search,
+        Add,
+        Email
+    };
+
+    static constexpr size_t max_params = 32;
+    static constexpr size_t max_body = 64 * 1024;
+
+    // false when the request is malformed: bad escapes, too many fields, a too large
+    // body or a body of a type other than application/x-www-form-urlencoded
+    bool parse(HTTPServerRequest &request)
+    {
+        _unsupported_body = false;
+        _body_unread = false;
+        const std::string &uri = request.getURI();
+        std::string_view query;
+        size_t qpos = uri.find('?');
+        if (qpos != std::string::npos)
+            query = std::string_view(uri).substr(qpos + 1);
+
+        bool form_body = request.getMethod() != Poco::Net::HTTPRequest::HTTP_GET &&
+                         request.getContentType().compare(0, 33, "application/x-www-form-urlencoded") == 0;
+        if (!form_body)
+        {
+            // multipart and other bodies are not parsed; refusing them keeps a
+            // request whose fields would be lost from running as a full listing
+            _unsupported_body = request.getMethod() != Poco::Net::HTTPRequest::HTTP_GET && has_body(request);
+            _body_unread = !skip_body(request);
+            return !_unsupported_body && parse(query, std::string_view());
+        }
+
+        std::istream &istr = request.stream();
+        std::string body;
+        if (request.hasContentLength() && request.getContentLength64() > 0)
+        {
+            if (request.getContentLength64() > static_cast<Poco::Int64>(max_body))
+            {
+                _body_unread = true;
+                return false;
+            }
+            body.resize(static_cast<size_t>(request.getContentLength64()));
+            istr.read(body.data(), body.size());
+            body.resize(static_cast<size_t>(istr.gcount()));
+        }
+        else
+        {
+            char chunk[4096];
+            while (istr.read(chunk, sizeof(chunk)) || istr.gcount() > 0)
+            {
+                body.append(chunk, static_cast<size_t>(istr.gcount()));
+                if (body.size() > max_body)
+                {
+                    _body_unread = true;
+                    return false;
+                }
+            }
+        }
+        return parse(query, body);
+    }
+
+    // consumes a body the handler does not use, so the next request on a
+    // persistent connection starts where the parser expects it. Bodies above
+    // max_body are not drained: false means the rest is still unread and the
+    // connection has to be closed after the response.
+    static bool skip_body(HTTPServerRequest &request)
+    {
+        if (!has_body(request))
+            return true;
+        if (request.hasContentLength() && request.getContentLength64() > static_cast<Poco::Int64>(max_body))
+            return false;
+        std::istream &istr = request.stream();
+        istr.ignore(static_cast<std::streamsize>(max_body) + 1);
+        return istr.gcount() <= static_cast<std::streamsize>(max_body);
+    }
+
+    // part of the request body was left on the connection
+    bool body_unread() const
+    {
+        return _body_unread;
+    }
+
+    // parse() failed because of the body type, not because of its content
+    bool unsupported_body() const
+    {
+        return _unsupported_body;
+    }
+
+    bool parse(std::string_view query, std::string_view body)
+    {
+        _count = 0;
+        _flags = 0;
+        _buffer.clear();
+        _buffer.reserve(query.size() + body.size() + 1);
+        _buffer.append(query.data(), query.size());
+        if (!body.empty())
+        {
+            _buffer += '&';
+            _buffer.append(body.data(), body.size());
+        }
+
+        char *data = _buffer.data();
+        size_t size = _buffer.size();
+        size_t pos = 0;
+        while (pos <= size)
+        {
+            size_t end = pos;
+            while (end < size && data[end] != '&')
+                ++end;
+            if (end > pos)
+            {
+                size_t eq = pos;
+                while (eq < end && data[eq] != '=')
+                    ++eq;
+                std::string_view name, value;
+                if (!decode(data + pos, data + eq, name))
+                    return false;
+                if (eq < end && !decode(data + eq + 1, data + end, value))
+                    return false;
+                if (_count == max_params)
+                    return false;
+                _params[_count++] = {name, value};
+                _flags |= flag_of(name);
+            }
+            pos = end + 1;
+        }
+        return true;
+    }
+
+    bool has(std::string_view name) const
+    {
+        for (size_t i = 0; i < _count; ++i)
+            if (_params[i].first == name)
+                return true;
+        return false;
+    }
+
+    std::string_view get(std::string_view name, std::string_view def = std::string_view()) const
+    {
+        for (size_t i = 0; i < _count; ++i)
+            if (_params[i].first == name)
+                return _params[i].second;
+        return def;
+    }
+
+    // the whole value must be a decimal number that fits into long
+    bool get_long(std::string_view name, long &value) const
+    {
+        std::string_view text = get(name);
+        if (text.empty())
+            return false;
+        auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+        return result.ec == std::errc() && result.ptr == text.data() + text.size();
+    }
+
+    Operation operation() const
+    {
+        if (_flags & flag_id)
+            return Operation::ById;
+        if (_flags & flag_search)
+            return Operation::Search;
+        if ((_flags & flag_add) && (_flags & add_fields) == add_fields)
+            return Operation::Add;
+        if ((_flags & flag_email) && !(_flags & flag_add))
+            return Operation::Email;
+        return Operation::List;
+    }
+
+private:
+    enum : unsigned
+    {
+        flag_id = 1,
+        flag_search = 2,
+        flag_add = 4,
+        flag_email = 8,
+        flag_first_name = 16,
+        flag_last_name = 32,
+        flag_title = 64,
+        add_fields = flag_first_name | flag_last_name | flag_email | flag_title
+    };
+
+    static unsigned flag_of(std::string_view name)
+    {
+        if (name == "id")
+            return flag_id;
+        if (name == "search")
+            return flag_search;
+        if (name == "add")
+            return flag_add;
+        if (name == "email")
+            return flag_email;
+        if (name == "first_name")
+            return flag_first_name;
+        if (name == "last_name")
+            return flag_last_name;
+        if (name == "title")
+            return flag_title;
+        return 0;
+    }
+
+    static bool has_body(HTTPServerRequest &request)
+    {
+        return (request.hasContentLength() && request.getContentLength64() > 0) || request.getChunkedTransferEncoding();
+    }
+
+    static int hex_value(char c)
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        return -1;
+    }
+
+    // decodes [begin,end) in place, the decoded text is never longer than the source
+    static bool decode(char *begin, char *end, std::string_view &out)
+    {
+        char *write = begin;
+        for (char *read = begin; read < end; ++read)
+        {
+            if (*read == '+')
+                *write++ = ' ';
+            else if (*read == '%')
+            {
+                if (end - read < 3)
+                    return false;
+                int hi = hex_value(read[1]);
+                int lo = hex_value(read[2]);
+                if (hi < 0 || lo < 0)
+                    return false;
+                *write++ = static_cast<char>(hi * 16 + lo);
+                read += 2;
+            }
+            else
+                *write++ = *read;
+        }
+        out = std::string_view(begin, write - begin);
+        return true;
+    }
+
+    std::string _buffer;
+    std::array<std::pair<std::string_view, std::string_view>, max_params> _params;
+    size_t _count = 0;
+    unsigned _flags = 0;
+    bool _unsupported_body = false;
+    bool _body_unread = false;
+};
+
+#endif // !REQUESTPARAMS_H
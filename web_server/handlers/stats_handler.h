@@ -0,0 +1,29 @@
+#ifndef STATSHANDLER_H
+#define STATSHANDLER_H
+
+#include "Poco/Net/HTTPRequestHandler.h"
+#include "Poco/Net/HTTPServerRequest.h"
+#include "Poco/Net/HTTPServerResponse.h"
+
+using Poco::Net::HTTPRequestHandler;
+using Poco::Net::HTTPServerRequest;
+using Poco::Net::HTTPServerResponse;
+
+#include "../../database/author_stats.h"
+#include "json_reply.h"
+#include "pooled_handler.h"
+
+// author totals by last name initial and email domain, served from memory
+class StatsHandler : public HTTPRequestHandler, public PooledHandler<StatsHandler>
+{
+public:
+    void handleRequest(HTTPServerRequest &request,
+                       HTTPServerResponse &response)
+    {
+        JsonReply::skip_body(request, response);
+        std::shared_ptr<const std::string> body = database::AuthorStats::get().json();
+        JsonReply::send(response, *body);
+    }
+
+};
+#endif // !STATSHANDLER_H
@@ -39,32 +39,82 @@ using Poco::Util::OptionCallback;
 using Poco::Util::HelpFormatter;
 
 #include "handlers/author_handler.h"
+#include "handlers/export_handler.h"
+#include "handlers/email_filter_handler.h"
+#include "handlers/admission_handler.h"
+#include "handlers/stats_handler.h"
+#include "handlers/connections_handler.h"
+#include "connection_stats.h"
 
-
-static bool startsWith(const std::string& str, const std::string& prefix)
-{
-    return str.size() >= prefix.size() && 0 == str.compare(0, prefix.size(), prefix);
-}
+#include <array>
+#include <string_view>
 
 
 class HTTPRequestFactory: public HTTPRequestHandlerFactory
 {
 public:
-    HTTPRequestFactory(const std::string& format):
-        _format(format)
-    {
-    }
-
     HTTPRequestHandler* createRequestHandler(
         const HTTPServerRequest& request)
     {
-        static std::string author="/author"; 
-        if (startsWith(request.getURI(),author)) return new AuthorHandler(_format);
+        ConnectionStats::get().on_request(request);
+
+        std::string_view path(request.getURI());
+        path = path.substr(0, path.find('?'));
+        for (const auto &entry : routes)
+            if (path == entry.path)
+                return create(entry.route);
+        // every other /author... URI keeps going to AuthorHandler
+        if (path.compare(0, author.size(), author) == 0)
+            return create(Route::Author);
         return 0;
     }
 
 private:
-    std::string _format;
+    enum class Route
+    {
+        Author,
+        Export,
+        EmailFilter,
+        Admission,
+        Stats,
+        Connections
+    };
+
+    struct RouteEntry
+    {
+        std::string_view path;
+        Route route;
+    };
+
+    static constexpr std::string_view author = "/author";
+    static constexpr std::array<RouteEntry, 6> routes = {{
+        {"/author", Route::Author},
+        {"/author/export", Route::Export},
+        {"/author/email_filter", Route::EmailFilter},
+        {"/author/admission", Route::Admission},
+        {"/author/stats", Route::Stats},
+        {"/author/connections", Route::Connections},
+    }};
+
+    static HTTPRequestHandler *create(Route route)
+    {
+        switch (route)
+        {
+        case Route::Author:
+            return new AuthorHandler();
+        case Route::Export:
+            return new ExportHandler();
+        case Route::EmailFilter:
+            return new EmailFilterHandler();
+        case Route::Admission:
+            return new AdmissionHandler();
+        case Route::Stats:
+            return new StatsHandler();
+        case Route::Connections:
+            return new ConnectionsHandler();
+        }
+        return 0;
+    }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -9,6 +9,7 @@
 #include "Poco/Net/HTTPServerResponse.h"
 #include "Poco/Net/HTTPServerParams.h"
 #include "Poco/Net/ServerSocket.h"
+#include "Poco/Timespan.h"
 #include "Poco/Timestamp.h"
 #include "Poco/DateTimeFormatter.h"
 #include "Poco/DateTimeFormat.h"
@@ -39,13 +40,17 @@ using Poco::Util::ServerApplication;
 
 #include "http_request_factory.h"
 #include "../config/config.h"
+#include "../logger/logger.h"
+#include "../database/author_stats.h"
+#include "../database/change_log.h"
+#include "../database/email_filter.h"
 
 
 
 class HTTPWebServer : public Poco::Util::ServerApplication
 {
 public:
-    HTTPWebServer() : _helpRequested(false){
+    HTTPWebServer() : _helpRequested(false), _initDB(false){
     }
 
     ~HTTPWebServer(){
@@ -102,6 +107,12 @@ protected:
                 .repeatable(false)
                 .argument("value")
                 .callback(OptionCallback<HTTPWebServer>(this, &HTTPWebServer::handleDatabase)));
+        options.addOption(
+            Option("storage", "st", "set author storage engine: mysql or memory")
+                .required(false)
+                .repeatable(false)
+                .argument("value")
+                .callback(OptionCallback<HTTPWebServer>(this, &HTTPWebServer::handleStorage)));
         options.addOption(
             Option("init_db", "it", "create database tables")
                 .required(false)
@@ -113,8 +124,7 @@ protected:
     void handleInitDB([[maybe_unused]] const std::string &name,
                       [[maybe_unused]] const std::string &value)
     {
-        std::cout << "init db" << std::endl;
-        database::Author::init();
+        _initDB = true;
     }
     void handleLogin([[maybe_unused]] const std::string &name,
                      [[maybe_unused]] const std::string &value)
@@ -135,6 +145,12 @@ protected:
         std::cout << "database:" << value << std::endl;
         Config::get().database() = value;
     }   
+    void handleStorage([[maybe_unused]] const std::string &name,
+                       [[maybe_unused]] const std::string &value)
+    {
+        std::cout << "storage:" << value << std::endl;
+        Config::get().storage() = value;
+    }
     void handlePort([[maybe_unused]] const std::string &name,
                     [[maybe_unused]] const std::string &value)
     {
@@ -171,21 +187,74 @@ protected:
             unsigned short port = (unsigned short)
                                       config()
                                           .getInt("HTTPWebServer.port", 80);
-            std::string format(
-                config().getString("HTTPWebServer.format",
-                                   DateTimeFormat::SORTABLE_FORMAT));
+            LogLevel log_level;
+            if (Logger::parse_level(config().getString("HTTPWebServer.log_level", "info"), log_level))
+                Logger::get().set_level(log_level);
+            Config::get().request_timeout() =
+                config().getInt("HTTPWebServer.request_timeout_ms", Config::get().get_request_timeout());
+            Config::get().max_request_timeout() =
+                config().getInt("HTTPWebServer.max_request_timeout_ms", Config::get().get_max_request_timeout());
+            Config::get().search_limit() =
+                config().getInt("HTTPWebServer.search_limit", Config::get().get_search_limit());
             
+            // deferred until all options are parsed, --storage picks the engine
+            if (_initDB)
+            {
+                std::cout << "init db" << std::endl;
+                database::Author::init();
+            }
+
+            // searches force the composite keys, add them to tables created before they existed
+            if (Config::get().get_storage() == "mysql")
+            {
+                try
+                {
+                    database::Author::create_indexes();
+                }
+                catch (std::exception &e)
+                {
+                    Logger::get().error("schema", std::string("can't add search keys:") + e.what());
+                }
+            }
+
+            std::string change_log_dir = config().getString("HTTPWebServer.change_log_dir", "");
+            if (!change_log_dir.empty() && Config::get().get_storage() != "mysql")
+                Logger::get().warning("change_log", "only used with mysql storage, disabled");
+            else if (!change_log_dir.empty())
+                database::ChangeLog::get().open(change_log_dir,
+                                                config().getInt("HTTPWebServer.change_log_segment_mb", 64) * 1024 * 1024);
+            database::ChangeLog::get().recover();
+            database::ChangeLog::get().start(config().getInt("HTTPWebServer.checkpoint_ms", 300000));
+            database::AuthorStats::get().start(config().getInt("HTTPWebServer.stats_reconcile_ms", 60000),
+                                               config().getInt("HTTPWebServer.stats_full_reconcile_ms", 6 * 3600 * 1000));
+            database::EmailFilter::get().start(config().getInt("HTTPWebServer.email_filter_refresh_ms", 10000));
+
             ServerSocket svs(Poco::Net::SocketAddress("0.0.0.0", port));
-            HTTPServer srv(new HTTPRequestFactory(format),
-                           svs, new HTTPServerParams);
+            HTTPServerParams::Ptr params = new HTTPServerParams;
+            // persistent connections: requests pipelined by a client are read
+            // and answered in order on the same connection thread
+            params->setKeepAlive(true);
+            params->setMaxKeepAliveRequests(config().getInt("HTTPWebServer.keep_alive_requests", 1000));
+            params->setKeepAliveTimeout(Poco::Timespan(config().getInt("HTTPWebServer.keep_alive_timeout_s", 10), 0));
+            params->setMaxThreads(config().getInt("HTTPWebServer.max_threads", params->getMaxThreads()));
+            params->setMaxQueued(config().getInt("HTTPWebServer.max_queued", params->getMaxQueued()));
+            HTTPServer srv(new HTTPRequestFactory(),
+                           svs, params);
+            AdmissionController::get().configure(&srv, params->getMaxThreads(),
+                                                 config().getInt("HTTPWebServer.max_queue_delay_ms", 200));
+            ConnectionStats::get().configure(&srv);
             srv.start();
             waitForTerminationRequest();
             srv.stop();
+            database::AuthorStats::get().stop();
+            database::EmailFilter::get().stop();
+            database::ChangeLog::get().stop();
         }
         return Application::EXIT_OK;
     }
 
 private:
     bool _helpRequested;
+    bool _initDB;
 };
 #endif // !HTTPWEBSERVER